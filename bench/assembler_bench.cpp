@@ -0,0 +1,283 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * assembles generated programs with the hasm executable and reports what an
+ * entry costs: the wall time, and the cache misses and instructions retired by
+ * the assembler when the kernel exposes the hardware counters
+ *
+ * usage: assembler_bench HASM WORK_DIR [CORPUS...]
+ *
+ * every corpus is assembled unless some are named
+ **/
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+  struct corpus_t {
+    const char* name;
+    const char* description;
+
+    /* writes the program and returns the number of lines written */
+    size_t (*generate)(std::ostream& out);
+  };
+
+  /* 16 control sections of 2^16 entries each, the most a section can hold
+   * while staying within the 20-bit address space */
+  size_t generate_program(std::ostream& out)
+  {
+    const char* entries =
+      "        LDA     #3\n"
+      "        STA     BUFFER,X\n"
+      "        +JSUB   FIRST\n"
+      "        +COMP   =C'EOF'    . compared against a literal\n"
+      "        BYTE    C'HELLO WORLD'\n"
+      "        WORD    5\n"
+      "        ADDR    A,X\n"
+      "        +LDT    BUFFER\n";
+
+    size_t nr_lines = 0;
+    for (int sect = 0; sect < 16; ++sect)
+    {
+      out
+        << "SECT" << sect << "   " << (sect ? "CSECT" : "START") << "   0\n"
+        << "FIRST   RSUB\n"
+        << "BUFFER  RESB    16\n";
+
+      for (int i = 0; i < 8192; ++i)
+        out << entries;
+
+      out << "        LTORG\n";
+      nr_lines += 4 + 8 * 8192;
+    }
+
+    out << "        END\n";
+    return nr_lines + 1;
+  }
+
+  /* entries that fail in pass 1: malformed constants and expressions, and
+   * operands referring to symbols that are never defined */
+  size_t generate_pass1_errors(std::ostream& out)
+  {
+    const size_t nr_lines = 60000;
+
+    out << "ERRS    START   0\n";
+    for (size_t i = 0; i < nr_lines; ++i)
+      switch (i % 6)
+      {
+        case 0: out << "W" << i << "      WORD    FWD" << i << "+1\n"; break;
+        case 1: out << "        BYTE    X'" << i << "G'\n"; break;
+        case 2: out << "        LDA     (" << i << "+\n"; break;
+        case 3: out << "        +LDA    @" << i << "\n"; break;
+        case 4: out << "        LDA     UNDEF" << i << "\n"; break;
+        case 5: out << "        LDA     #" << i << "\n"; break;
+      }
+    out << "        END\n";
+
+    return nr_lines + 2;
+  }
+
+  /* a program that reads fine but fails to assemble: undefined symbols and
+   * targets that can not be reached */
+  size_t generate_pass2_errors(std::ostream& out)
+  {
+    const size_t nr_lines = 60000;
+
+    out << "ERRS    START   0\n";
+    for (size_t i = 0; i < nr_lines; ++i)
+      switch (i % 3)
+      {
+        case 0: out << "        +LDA    @" << i << "\n"; break;
+        case 1: out << "        LDA     UNDEF" << i << "\n"; break;
+        case 2: out << "        LDA     " << 5000 + i << "\n"; break;
+      }
+    out << "        END\n";
+
+    return nr_lines + 2;
+  }
+
+  const corpus_t corpora[] = {
+    { "program", "1M lines of instructions and data", &generate_program },
+    { "pass1-errors", "an error on every other line, found while reading", &generate_pass1_errors },
+    { "pass2-errors", "an error on every line, found while assembling", &generate_pass2_errors },
+  };
+
+  /* the events counted for the assembler, if the kernel lets us */
+  struct counters_t {
+    bool available;
+    std::string error;
+    uint64_t cache_misses;
+    uint64_t instructions;
+  };
+
+  int open_counter(pid_t in_pid, uint64_t in_config, int in_group)
+  {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = in_config;
+    attr.disabled = in_group == -1;
+    attr.enable_on_exec = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, in_pid, -1, in_group, 0));
+  }
+
+  /**
+   * runs the assembler on in_asm with its listing discarded and returns the
+   * wall time in nanoseconds; the counters are attached to the child before
+   * it executes the assembler, so only the assembler is counted
+   **/
+  double run(std::string const& in_hasm, std::string const& in_asm,
+             std::string const& in_obj, counters_t& out_counters)
+  {
+    int go[2];
+    if (::pipe(go) == -1)
+      throw std::runtime_error(std::string("pipe: ") + std::strerror(errno));
+
+    pid_t child = ::fork();
+    if (child == -1)
+      throw std::runtime_error(std::string("fork: ") + std::strerror(errno));
+
+    if (child == 0)
+    {
+      char c;
+      ::close(go[1]);
+      if (::read(go[0], &c, 1) != 1)
+        ::_exit(127);
+
+      int devnull = ::open("/dev/null", O_WRONLY);
+      ::dup2(devnull, STDOUT_FILENO);
+      ::execl(in_hasm.c_str(), in_hasm.c_str(), "-o", in_obj.c_str(), in_asm.c_str(), (char*)0);
+      ::_exit(127);
+    }
+
+    ::close(go[0]);
+
+    int misses = open_counter(child, PERF_COUNT_HW_CACHE_MISSES, -1);
+    int instructions = misses == -1 ? -1 : open_counter(child, PERF_COUNT_HW_INSTRUCTIONS, misses);
+    out_counters.available = misses != -1 && instructions != -1;
+    if (!out_counters.available)
+      out_counters.error = std::strerror(errno);
+
+    typedef std::chrono::steady_clock clock_t;
+    clock_t::time_point begin = clock_t::now();
+
+    char c = 0;
+    if (::write(go[1], &c, 1) != 1)
+      throw std::runtime_error(std::string("write: ") + std::strerror(errno));
+    ::close(go[1]);
+
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    std::chrono::duration<double, std::nano> elapsed = clock_t::now() - begin;
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) == 127)
+      throw std::runtime_error("the assembler could not be run: " + in_hasm);
+
+    if (out_counters.available)
+    {
+      if (::read(misses, &out_counters.cache_misses, sizeof(uint64_t)) != sizeof(uint64_t) ||
+          ::read(instructions, &out_counters.instructions, sizeof(uint64_t)) != sizeof(uint64_t))
+        out_counters.available = false;
+    }
+
+    if (misses != -1)
+      ::close(misses);
+    if (instructions != -1)
+      ::close(instructions);
+
+    return elapsed.count();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    std::cerr << "usage: assembler_bench HASM WORK_DIR [CORPUS...]\n";
+    return 1;
+  }
+
+  std::string hasm = argv[1];
+  std::string work_dir = argv[2];
+
+  for (corpus_t const& corpus : corpora)
+  {
+    bool selected = argc == 3;
+    for (int i = 3; i < argc; ++i)
+      selected = selected || corpus.name == std::string(argv[i]);
+
+    if (!selected)
+      continue;
+
+    std::string asm_path = work_dir + "/" + corpus.name + ".asm";
+    std::string obj_path = work_dir + "/" + corpus.name + ".obj";
+
+    std::ofstream out(asm_path);
+    size_t nr_lines = corpus.generate(out);
+    out.close();
+
+    // the fastest of a few runs, along with what it was counted to cost
+    double best = 0;
+    counters_t counters;
+    for (int i = 0; i < 3; ++i)
+    {
+      counters_t run_counters;
+      double ns = run(hasm, asm_path, obj_path, run_counters);
+      if (i == 0 || ns < best)
+      {
+        best = ns;
+        counters = run_counters;
+      }
+    }
+
+    std::cout
+      << corpus.name << ": " << corpus.description << "\n"
+      << "  lines:                " << nr_lines << "\n"
+      << "  wall time:            " << std::fixed << std::setprecision(1) << best / 1e6 << " ms, "
+      << best / nr_lines << " ns per line\n";
+
+    if (counters.available)
+      std::cout
+        << "  cache misses:         " << double(counters.cache_misses) / nr_lines << " per line\n"
+        << "  instructions retired: " << double(counters.instructions) / nr_lines << " per line\n";
+    else
+      std::cout << "  hardware counters are not available: " << counters.error << "\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_bench_h
+#define h_bench_h
+
+#include <chrono>
+#include <cstddef>
+
+namespace hax
+{
+namespace bench {
+
+  /**
+   * runs in_fn in_runs times and returns the fastest run in nanoseconds per
+   * operation, given that every run performs in_nr_ops operations
+   **/
+  template <typename Fn>
+  double best_ns_per_op(Fn in_fn, size_t in_nr_ops, int in_runs = 5)
+  {
+    typedef std::chrono::steady_clock clock_t;
+
+    double best = 0;
+    for (int run = 0; run < in_runs; ++run)
+    {
+      clock_t::time_point begin = clock_t::now();
+      in_fn();
+      std::chrono::duration<double, std::nano> elapsed = clock_t::now() - begin;
+
+      double ns = elapsed.count() / (in_nr_ops ? in_nr_ops : 1);
+      if (run == 0 || ns < best)
+        best = ns;
+    }
+
+    return best;
+  }
+
+  /* keeps the compiler from discarding a result that is only computed to be timed */
+  template <typename T>
+  inline void keep(T const& in_value)
+  {
+    asm volatile("" : : "g"(&in_value) : "memory");
+  }
+} // end of namespace bench
+} // end of namespace
+#endif // h_bench_h
@@ -0,0 +1,108 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * times the charconv-based utility::parse_number and utility::to_string
+ * against the stream-based convertTo and stringify they replaced, on the
+ * decimal terms that expressions are evaluated over
+ *
+ * usage: conversion_bench
+ **/
+
+#include "bench.hpp"
+#include "hax_utility.hpp"
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  /* the stream-based conversions as they were before charconv */
+  namespace stream {
+
+    template<typename T>
+    inline std::string stringify(const T& x)
+    {
+      std::ostringstream o;
+      if (!(o << x))
+        throw hax::bad_conversion(std::string("stringify(") + typeid(x).name() + ")");
+      return o.str();
+    }
+
+    template<typename T>
+    inline T convertTo(const std::string& inString)
+    {
+      T value;
+      std::istringstream buffer(inString);
+      char c;
+      if (!(buffer >> value) || buffer.get(c))
+        throw hax::bad_conversion(inString);
+      return value;
+    }
+  }
+}
+
+int main()
+{
+  const size_t nr_terms = 1000000;
+
+  std::mt19937 rng(0x5ca9);
+  std::uniform_int_distribution<int> value(-8388608, 8388607);
+
+  std::vector<int> values;
+  std::vector<std::string> terms;
+  for (size_t i = 0; i < nr_terms; ++i)
+  {
+    values.push_back(value(rng));
+    terms.push_back(std::to_string(values.back()));
+  }
+
+  double stream_parse = hax::bench::best_ns_per_op([&]() {
+    for (std::string const& term : terms)
+      hax::bench::keep(stream::convertTo<int>(term));
+  }, nr_terms);
+
+  double charconv_parse = hax::bench::best_ns_per_op([&]() {
+    for (std::string const& term : terms)
+      hax::bench::keep(hax::utility::parse_number<int>(term));
+  }, nr_terms);
+
+  double stream_format = hax::bench::best_ns_per_op([&]() {
+    for (int v : values)
+      hax::bench::keep(stream::stringify(v));
+  }, nr_terms);
+
+  double charconv_format = hax::bench::best_ns_per_op([&]() {
+    for (int v : values)
+      hax::bench::keep(hax::utility::to_string(v));
+  }, nr_terms);
+
+  std::cout
+    << std::fixed << std::setprecision(1)
+    << std::setw(10) << "" << std::setw(12) << "stream" << std::setw(12) << "charconv"
+    << "  (ns per term)\n"
+    << std::setw(10) << "parse" << std::setw(12) << stream_parse << std::setw(12) << charconv_parse << "\n"
+    << std::setw(10) << "format" << std::setw(12) << stream_format << std::setw(12) << charconv_format << "\n";
+
+  return 0;
+}
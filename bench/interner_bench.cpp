@@ -0,0 +1,122 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * times symbol name lookups in the string_interner, against the std::map the
+ * symbol manager used before, for 1K up to 1M names
+ *
+ * names look like SIC/XE labels, and are looked up in a shuffled order so the
+ * tables are not walked in the order they were filled. The cost of a lookup
+ * should stay flat as the number of names grows, apart from what the larger
+ * tables pay in cache misses.
+ *
+ * usage: interner_bench
+ **/
+
+#include "bench.hpp"
+#include "string_interner.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using hax::string_interner;
+
+namespace {
+
+  /* a label of up to six characters, unique for every index */
+  std::string label(size_t in_index)
+  {
+    const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+    std::string name(1, 'L');
+    do {
+      name += digits[in_index % 36];
+      in_index /= 36;
+    } while (in_index);
+
+    return name;
+  }
+}
+
+int main()
+{
+  std::mt19937 rng(0x5ca9);
+
+  std::cout
+    << std::setw(10) << "names"
+    << std::setw(18) << "interner hit"
+    << std::setw(18) << "interner miss"
+    << std::setw(18) << "std::map hit"
+    << "  (ns per lookup)\n";
+
+  for (size_t nr_names = 1000; nr_names <= 1000000; nr_names *= 10)
+  {
+    std::vector<std::string> names, missing;
+    for (size_t i = 0; i < nr_names; ++i)
+    {
+      names.push_back(label(i));
+      missing.push_back(label(i + nr_names));
+    }
+
+    hax::arena_t arena;
+    string_interner interner(arena);
+    std::map<std::string, string_interner::id_t> map;
+    for (std::string const& name : names)
+      map.emplace(name, interner.intern(name));
+
+    std::shuffle(names.begin(), names.end(), rng);
+
+    // every run looks up at least a million names
+    size_t rounds = std::max<size_t>(1, 1000000 / nr_names);
+    size_t nr_lookups = rounds * nr_names;
+
+    double hit = hax::bench::best_ns_per_op([&]() {
+      for (size_t r = 0; r < rounds; ++r)
+        for (std::string const& name : names)
+          hax::bench::keep(interner.find(name));
+    }, nr_lookups);
+
+    double miss = hax::bench::best_ns_per_op([&]() {
+      for (size_t r = 0; r < rounds; ++r)
+        for (std::string const& name : missing)
+          hax::bench::keep(interner.find(name));
+    }, nr_lookups);
+
+    double map_hit = hax::bench::best_ns_per_op([&]() {
+      for (size_t r = 0; r < rounds; ++r)
+        for (std::string const& name : names)
+          hax::bench::keep(map.find(name));
+    }, nr_lookups);
+
+    std::cout
+      << std::fixed << std::setprecision(1)
+      << std::setw(10) << nr_names
+      << std::setw(18) << hit
+      << std::setw(18) << miss
+      << std::setw(18) << map_hit
+      << "\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_arena_h
+#define h_arena_h
+
+#include "hax.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace hax
+{
+  /**
+   * a bump-pointer allocator for the objects that make up the intermediate
+   * representation of a control section: instructions, operands, symbols
+   * and relocation records
+   *
+   * memory is carved out of large chunks and is never returned piecemeal,
+   * everything is released at once when the arena is destroyed; objects
+   * that are not trivially destructible have their destructors run at that
+   * point, in the reverse order of their creation
+   *
+   * @note
+   * objects created in an arena must not be deleted explicitly
+   **/
+  class arena {
+    public:
+
+    /* the default amount of bytes requested from the heap per chunk */
+    static const size_t chunk_size;
+
+    arena();
+    virtual ~arena();
+
+    arena(const arena& src)=delete;
+    arena& operator=(const arena& rhs)=delete;
+
+    /**
+     * constructs a T in the arena from in_args and returns it, the object
+     * lives until the arena is destroyed
+     **/
+    template <typename T, typename... Args>
+    T* create(Args&&... in_args)
+    {
+      void* mem = allocate(sizeof(T), alignof(T));
+      T* obj = new (mem) T(std::forward<Args>(in_args)...);
+
+      if (!std::is_trivially_destructible<T>::value)
+        track_destructor(obj, &arena::destroy<T>);
+
+      return obj;
+    }
+
+    /**
+     * returns in_size bytes of uninitialized memory aligned to in_align
+     **/
+    void* allocate(size_t in_size, size_t in_align);
+
+    /* the number of allocations served, and chunks requested from the heap */
+    size_t nr_allocations() const;
+    size_t nr_chunks() const;
+
+    protected:
+    struct chunk_t {
+      chunk_t* next;
+    };
+
+    struct destructor_t {
+      void (*destroy)(void*);
+      void* object;
+      destructor_t* next;
+    };
+
+    template <typename T>
+    static void destroy(void* in_object)
+    {
+      static_cast<T*>(in_object)->~T();
+    }
+
+    void track_destructor(void* in_object, void (*in_destroy)(void*));
+
+    /* requests a chunk able to hold at least in_size bytes */
+    void grow(size_t in_size);
+
+    char* cursor_;
+    char* limit_;
+    chunk_t* chunks_;
+    destructor_t* destructors_;
+    size_t nr_allocations_;
+    size_t nr_chunks_;
+  };
+
+  typedef arena arena_t;
+} // end of namespace
+#endif // h_arena_h
@@ -0,0 +1,82 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_constant_pool_h
+#define h_constant_pool_h
+
+#include "hax.hpp"
+#include "string_interner.hpp"
+#include "operand_classifier.hpp"
+#include "operands/constant.hpp"
+#include <vector>
+
+namespace hax
+{
+  class control_section;
+
+  /**
+   * hash-conses the constant operands of a control section: every distinct
+   * decimal, hexadecimal and ASCII constant is created and evaluated once,
+   * and the same read-only object is shared by all instructions using it
+   *
+   * constants are keyed on their token without the addressing mode prefix,
+   * so #3 and 3 share an operand while 3 and 03 do not (their lengths differ)
+   *
+   * literals and the location counter operator * depend on where they are
+   * used and are never pooled
+   **/
+  class constant_pool {
+    public:
+
+    explicit constant_pool(control_section* in_sect);
+    virtual ~constant_pool();
+
+    constant_pool(const constant_pool& src)=delete;
+    constant_pool& operator=(const constant_pool& rhs)=delete;
+
+    /**
+     * whether constants of the class in_class can be shared
+     **/
+    static bool is_poolable(operand_class_t const& in_class);
+
+    /**
+     * assigns the shared constant for in_token, which has been classified as
+     * in_class, to out_constant, creating and evaluating it if it is the first
+     * of its kind
+     *
+     * fails if the constant can not be evaluated, in which case it is not
+     * pooled and the error points at in_line, the source line of the
+     * instruction that asked for it
+     **/
+    status_t acquire(std::string_view in_token, operand_class_t const& in_class, string_t const& in_line,
+                     constant_t*& out_constant);
+
+    /* the number of distinct constants in the pool */
+    size_t size() const;
+
+    protected:
+    control_section* sect_;
+    string_interner keys_;
+
+    /* indexed by the id of the key */
+    std::vector<constant_t*> constants_;
+  };
+} // end of namespace
+#endif // h_constant_pool_h
@@ -25,6 +25,10 @@
 #include "program_block.hpp"
 #include "symbol_manager.hpp"
 #include "loggable.hpp"
+#include "arena.hpp"
+#include "instruction_store.hpp"
+#include "constant_pool.hpp"
+#include "expression_pool.hpp"
 
 namespace hax
 {
@@ -40,7 +44,6 @@ namespace hax
   class control_section : public loggable {
     public:
 
-    typedef std::list<instruction_t*> instructions_t;
     typedef std::list<pblock_t*> pblocks_t;
 
 		control_section(string_t in_name);
@@ -53,6 +56,23 @@ namespace hax
     string_t const& name() const;
     symbol_manager* symmgr() const;
 
+    /**
+     * the arena all instructions, operands, symbols and relocation records
+     * of this section are created in, they are all released along with the
+     * section
+     **/
+    arena_t& arena();
+
+    /**
+     * the constant operands shared by the instructions of this section
+     **/
+    constant_pool& constants();
+
+    /**
+     * the expression operands shared by the instructions of this section
+     **/
+    expression_pool& expressions();
+
     /**
      * the total size of this control section in bytes (sum of lengs of all pblocks)
      **/
@@ -72,19 +92,23 @@ namespace hax
     pblocks_t const& program_blocks() const;
 
     /**
-     * registers the given instruction in the control section's master instruction list
+     * registers the given instruction in the control section's instruction store
      *
      * @warning
-     * ownership of all instruction objects contained in a control section's
-     * program blocks belongs to the CS object itself and must not be freed
-     * explicitly
+     * instruction objects contained in a control section's program blocks
+     * are created in the CS arena and must not be freed explicitly
      *
      * @note
      * this method is called internally by program_block::add_instruction()
      **/
     void __add_instruction(instruction_t* in_inst);
 
-    instructions_t const& instructions() const;
+    /**
+     * the instructions of all program blocks in this section, in the order they
+     * were registered
+     **/
+    instruction_store& instructions();
+    instruction_store const& instructions() const;
 
     /**
      * assigns addresses to all registered program blocks, then attempts to assemble
@@ -109,10 +133,17 @@ namespace hax
     virtual std::ostream& to_stream(std::ostream&) const;
 
     string_t name_;
+
+    // constructed before, and destroyed after, everything that refers to the
+    // objects it holds
+    arena_t arena_;
+
     pblocks_t pblocks_;
     pblock_t *pblock_;
     symbol_manager *symmgr_;
-    instructions_t instructions_;
+    instruction_store instructions_;
+    constant_pool constants_;
+    expression_pool expressions_;
     loc_t starting_addr_;
     bool starting_addr_set_;
 	};
@@ -0,0 +1,220 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_encoders_h
+#define h_encoders_h
+
+#include "hax.hpp"
+#include "instruction.hpp"
+#include <vector>
+
+namespace hax
+{
+  /**
+   * pass 2 encoders of format 2, 3 and 4 instructions
+   *
+   * there is one encoder for every format, addressing mode and indexing
+   * combination; the nixbpe flags an encoder sets are fixed by its template
+   * arguments, so the only work left for pass 2 is computing the address or
+   * displacement field
+   *
+   * format 4 instructions select their encoder once when their operand is
+   * assigned, see encoding::select_fmt4(); format 3 instructions are encoded
+   * by an encoding::fmt3_batch, and the fmt3 encoders picked by
+   * encoding::select_fmt3() are the reference the batch must agree with
+   **/
+  class fmt3_instruction;
+
+  namespace encoding {
+
+    /* the x, b, p and e bits of a format 3 object code, e is shifted by 8 more in format 4 */
+    enum : objcode_t {
+      fmt3_x = 0x008000,
+      fmt3_b = 0x004000,
+      fmt3_p = 0x002000,
+      fmt4_x = 0x00800000,
+      fmt4_e = 0x00100000
+    };
+
+    /**
+     * returned by format 3 encoders when the target can not be reached by
+     * any of the targeting modes, and by format 4 encoders when it does not
+     * fit in the 20-bit address field
+     **/
+    constexpr objcode_t out_of_bounds = 0xFFFFFFFF;
+
+    /**
+     * encodes in_opcode against in_target, which is the target address or the
+     * constant value of the operand; in_pc is the location of the instruction
+     * that follows and in_base is the content of the base register
+     **/
+    typedef objcode_t (*encoder_t)(opcode_t in_opcode, int in_target, int in_pc, int in_base);
+
+    /**
+     * format 2 object code is the opcode followed by two 4-bit fields, which
+     * hold register numbers or, for SHIFTL, SHIFTR and SVC, a count
+     **/
+    struct fmt2 {
+      static constexpr bool fits(uint32_t in_field)
+      {
+        return in_field <= 0xF;
+      }
+
+      static constexpr objcode_t encode(opcode_t in_opcode, uint32_t in_r1, uint32_t in_r2)
+      {
+        return (objcode_t(in_opcode) << 8) | (in_r1 << 4) | in_r2;
+      }
+    };
+
+    template <uint32_t Mode, bool Indexed>
+    struct fmt3 {
+      static_assert(Mode == instruction::simple || Mode == instruction::indirect || Mode == instruction::immediate,
+        "format 3 instructions are either simple, indirect or immediate");
+
+      static constexpr objcode_t head(opcode_t in_opcode)
+      {
+        return (objcode_t(in_opcode) << 16) | Mode | (Indexed ? fmt3_x : 0);
+      }
+
+      /**
+       * constant operands are encoded as they are, they must fit in the 12 bits
+       * of the displacement field
+       **/
+      static constexpr objcode_t absolute(opcode_t in_opcode, int in_target, int, int)
+      {
+        if (in_target < 0 || in_target > 0xFFF)
+          return out_of_bounds;
+
+        return head(in_opcode) | objcode_t(in_target);
+      }
+
+      /**
+       * addresses are reached PC-relative if possible, then base-relative, and
+       * finally directly if they fall within the first 4096 bytes
+       **/
+      static constexpr objcode_t relative(opcode_t in_opcode, int in_target, int in_pc, int in_base)
+      {
+        int disp = in_target - in_pc;
+        if (disp >= -2048 && disp <= 2047)
+          return head(in_opcode) | fmt3_p | (objcode_t(disp) & 0xFFF);
+
+        disp = in_target - in_base;
+        if (disp >= 0 && disp <= 4095)
+          return head(in_opcode) | fmt3_b | objcode_t(disp);
+
+        return absolute(in_opcode, in_target, in_pc, in_base);
+      }
+    };
+
+    template <uint32_t Mode, bool Indexed>
+    struct fmt4 {
+      static_assert(Mode == instruction::simple || Mode == instruction::immediate,
+        "format 4 instructions are either simple or immediate");
+
+      /**
+       * the target must fit in the 20 bits of the address field, either as an
+       * address or a constant, or as a negative offset from an external
+       * reference that a modification record completes
+       **/
+      static constexpr objcode_t encode(opcode_t in_opcode, int in_target, int, int)
+      {
+        if (in_target < -0x80000 || in_target > 0xFFFFF)
+          return out_of_bounds;
+
+        return (objcode_t(in_opcode) << 24)
+             | (Mode << 8)
+             | (Indexed ? fmt4_x : 0)
+             | fmt4_e
+             | (objcode_t(in_target) & 0xFFFFF);
+      }
+    };
+
+    /**
+     * picks the format 3 encoder for the given addressing mode and indexing,
+     * constant operands are encoded absolutely while all others are relative
+     **/
+    encoder_t select_fmt3(uint32_t in_mode, bool in_indexed, bool in_constant);
+
+    /**
+     * picks the format 4 encoder for the given addressing mode and indexing,
+     * returns 0 for indirect addressing which extended formats can not use
+     **/
+    encoder_t select_fmt4(uint32_t in_mode, bool in_indexed);
+
+    /**
+     * encodes the format 3 instructions of a control section in one go once
+     * pass 1 has fixed their locations
+     *
+     * the operands of the gathered instructions are laid out in contiguous
+     * arrays and the PC-relative, base-relative and direct targeting modes
+     * are tried on all of them without branching, 4 instructions at a time
+     * using SSE2 when available; the results are identical to those of the
+     * encoders picked by select_fmt3(), which debug builds cross-check
+     * against and the encoders test compares over generated operands
+     **/
+    class fmt3_batch {
+      public:
+
+      /**
+       * queues in_inst for encoding in the addressing mode in_mode, which is
+       * one of instruction::addressing_mode, in_absolute is set for constant
+       * operands, which are only encoded directly
+       **/
+      void add(fmt3_instruction* in_inst, opcode_t in_opcode, uint32_t in_mode, bool in_indexed,
+               bool in_absolute, int in_target, int in_pc, int in_base);
+
+      /* the opcode, n, i and x bits of a format 3 object code */
+      static objcode_t head(opcode_t in_opcode, uint32_t in_mode, bool in_indexed);
+
+      /**
+       * encodes every queued instruction, entries whose target can not be
+       * reached are assigned out_of_bounds
+       **/
+      void encode();
+
+      size_t size() const;
+      void clear();
+
+      fmt3_instruction* instruction_at(size_t in_idx) const;
+      objcode_t objcode_at(size_t in_idx) const;
+      int target_at(size_t in_idx) const;
+
+      static void encode_scalar(const objcode_t* in_heads, const uint32_t* in_absolute,
+                                const int32_t* in_targets, const int32_t* in_pcs,
+                                const int32_t* in_bases, objcode_t* out_objcodes, size_t in_count);
+      static void encode_sse2(const objcode_t* in_heads, const uint32_t* in_absolute,
+                              const int32_t* in_targets, const int32_t* in_pcs,
+                              const int32_t* in_bases, objcode_t* out_objcodes, size_t in_count);
+
+      protected:
+      std::vector<fmt3_instruction*> insts_;
+      std::vector<objcode_t> heads_;
+
+      /* all bits set for constant operands, which are only encoded directly */
+      std::vector<uint32_t> absolute_;
+
+      std::vector<int32_t> targets_;
+      std::vector<int32_t> pcs_;
+      std::vector<int32_t> bases_;
+      std::vector<objcode_t> objcodes_;
+    };
+  } // end of namespace encoding
+} // end of namespace
+#endif // h_encoders_h
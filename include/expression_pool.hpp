@@ -0,0 +1,73 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_expression_pool_h
+#define h_expression_pool_h
+
+#include "hax.hpp"
+#include "string_interner.hpp"
+#include "operand_classifier.hpp"
+#include "operands/expression.hpp"
+#include <vector>
+
+namespace hax
+{
+  class control_section;
+
+  /**
+   * hash-conses the expression operands of a control section: every distinct
+   * expression is compiled once, and the same read-only object is shared by
+   * all instructions using it, so it is also evaluated once per epoch of the
+   * symbol table (see symbol_manager::epoch())
+   *
+   * expressions are keyed on their token without the addressing mode prefix,
+   * so #BUFEND-BUFFER and BUFEND-BUFFER share an operand
+   **/
+  class expression_pool {
+    public:
+
+    explicit expression_pool(control_section* in_sect);
+    virtual ~expression_pool();
+
+    expression_pool(const expression_pool& src)=delete;
+    expression_pool& operator=(const expression_pool& rhs)=delete;
+
+    /**
+     * assigns the shared expression for in_token, which has been classified
+     * as in_class, to out_expr, compiling it if it is the first of its kind
+     *
+     * fails if the expression can not be compiled, the error is reported
+     * against in_inst and the expression is not pooled
+     **/
+    status_t acquire(std::string_view in_token, operand_class_t const& in_class, instruction* in_inst,
+                     expression_t*& out_expr);
+
+    /* the number of distinct expressions in the pool */
+    size_t size() const;
+
+    protected:
+    control_section* sect_;
+    string_interner keys_;
+
+    /* indexed by the id of the key */
+    std::vector<expression_t*> expressions_;
+  };
+} // end of namespace
+#endif // h_expression_pool_h
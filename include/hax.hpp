@@ -23,6 +23,7 @@
 
 #include "hax_types.hpp"
 #include "hax_exception.hpp"
+#include "hax_status.hpp"
 #include "hax_utility.hpp"
 
 #endif
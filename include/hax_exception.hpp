@@ -137,7 +137,7 @@ namespace hax {
    *  2. RESB, RESW, BYTE, and WORD operations given a non-constant or absolute
    *     expression operand
    *  3. RESB and RESW given a non-evaluated expression
-   *  4. EQU passed non-evaluated arguments, they all must be previously defined
+   *  4. EQU passed arguments referring to symbols that are never defined
    **/
 	class invalid_operand : public parser_error {
 	public:
@@ -171,6 +171,18 @@ namespace hax {
 		{ }
 	};
 
+  /* circular definition:
+   *
+   * raised when EQU directives define symbols in terms of one another, the
+   * message spells out the cycle, e.g. A -> B -> A
+   **/
+	class circular_definition : public parser_error {
+	public:
+		inline circular_definition(const string_t& s, string_t const& line)
+		: parser_error(s, "circular definition", line)
+		{ }
+	};
+
   /* unrecognized operation:
    *
    * thrown when a given OPCODE could not be found in the master op table
@@ -206,6 +218,19 @@ namespace hax {
 		{ }
 	};
 
+  /* address overflow:
+   *
+   * raised when the location counter of a program block, or the program blocks
+   * of a control section laid out together, run past the 20-bit SIC/XE
+   * address space
+   **/
+	class address_overflow : public parser_error {
+	public:
+		inline address_overflow(const string_t& s, const string_t& line)
+		: parser_error(s, "address overflow", line)
+		{ }
+	};
+
   /* ------------------------------------------------------------------------ */
   /* internal errors:
    *
@@ -222,7 +247,7 @@ namespace hax {
 
   /* bad conversion
    *
-   * thrown when an argument passed to utility::convertTo<> is not a number
+   * thrown when an argument passed to utility::parse_number<> is not a number
    * and thus can not be converted
    **/
 	class bad_conversion : public internal_error {
@@ -237,6 +262,9 @@ namespace hax {
    * raised when attempting to access an operand's value before calling its
    * operand::evaluate() routine, this is an internal error and should really
    * not happen
+   *
+   * expressions also fail to evaluate with it while a symbol they refer to is
+   * not resolved, see expression::evaluate()
    **/
 	class unevaluated_operand : public internal_error {
 	public:
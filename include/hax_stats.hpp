@@ -0,0 +1,71 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_hax_stats_h
+#define h_hax_stats_h
+
+#include <cstdint>
+#include <ostream>
+
+namespace hax
+{
+  /**
+   * counters gathered while assembling, they are printed at exit when the
+   * assembler is run with -s
+   *
+   * heap allocations are only counted in builds configured with
+   * HASM_COUNT_ALLOCATIONS, which define HAX_COUNT_ALLOCATIONS: the global
+   * operator new is then replaced by one that counts every allocation made by
+   * the program, including those of the standard containers. Other builds
+   * leave the allocator alone and the heap counters at zero.
+   **/
+  namespace stats {
+
+    /* the number of source entries read in pass 1 */
+    extern uint64_t lines;
+
+    extern uint64_t heap_allocations;
+
+    /* heap allocations made while reading the source in pass 1 */
+    extern uint64_t pass1_heap_allocations;
+
+    /* objects created in, and chunks requested by, the control section arenas */
+    extern uint64_t arena_allocations;
+    extern uint64_t arena_chunks;
+
+    /* distinct constant operands created by the constant pools, the number of
+     * times one was shared instead of created, and the bytes that saved */
+    extern uint64_t pooled_constants;
+    extern uint64_t shared_constants;
+    extern uint64_t shared_constant_bytes;
+
+    /* distinct expression operands compiled by the expression pools, the
+     * number of times one was shared instead of compiled, the operations on
+     * absolute terms folded while compiling, and the evaluations skipped since
+     * their result was memoized */
+    extern uint64_t pooled_expressions;
+    extern uint64_t shared_expressions;
+    extern uint64_t folded_operations;
+    extern uint64_t saved_evaluations;
+
+    void dump(std::ostream& out);
+  } // end of namespace stats
+} // end of namespace
+#endif // h_hax_stats_h
@@ -0,0 +1,74 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_hax_status_h
+#define h_hax_status_h
+
+#include "hax_exception.hpp"
+#include <memory>
+
+namespace hax
+{
+  /**
+   * the outcome of a step in assembling the input program that may fail on
+   * account of the program itself: such errors are expected, and plenty of
+   * them in a broken program, so they are handed back to the caller to be
+   * tracked rather than thrown and unwound through every frame in between
+   *
+   * a status that is ok costs no more than a null pointer, a failed one holds
+   * the error that would otherwise have been thrown; exceptions are left for
+   * fatal conditions, like an unreadable input or a corrupt literal table
+   *
+   * statuses can only be moved, and must not be discarded
+   **/
+  class [[nodiscard]] status {
+    public:
+    status()=default;
+    status(status&& src)=default;
+    status& operator=(status&& rhs)=default;
+    status(const status& src)=delete;
+    status& operator=(const status& rhs)=delete;
+
+    /**
+     * a failed status holding a copy of in_error
+     **/
+    template<typename T>
+    static status failure(T const& in_error)
+    {
+      status out;
+      out.error_.reset(new T(in_error));
+      return out;
+    }
+
+    bool ok() const { return !error_; }
+
+    /**
+     * @note
+     * only failed statuses hold an error, be sure to check ok() first
+     **/
+    hax_error& error() const { return *error_; }
+
+    protected:
+    std::unique_ptr<hax_error> error_;
+  };
+
+  typedef status status_t;
+} // end of namespace
+#endif // h_hax_status_h
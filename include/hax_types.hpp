@@ -22,6 +22,7 @@
 #define h_hax_types_h
 
 #include <string>
+#include <cstdint>
 #include <tuple>
 #include <iomanip>
 #include <cassert>
@@ -34,11 +35,22 @@ namespace hax {
   class hax_error;
 
   typedef uint8_t opcode_t;
-  typedef uint16_t loc_t;
+  typedef uint32_t loc_t;
   typedef uint32_t objcode_t;
   typedef std::string string_t;
   typedef char format_t;
-  typedef std::tuple<opcode_t, format_t> opcode_fmt_t;
+
+  /* SIC/XE addresses a memory of 1 MiB, so locations are 20 bits wide */
+  const loc_t address_space = 1 << 20;
+
+  /* symbols are identified by the id their name is interned as in their section */
+  typedef uint32_t symbol_id_t;
+
+  /* a run of bytes owned elsewhere, like the data of a BYTE directive or a literal */
+  struct byte_span_t {
+    const uint8_t* data;
+    uint32_t length;
+  };
 }
 
 #endif
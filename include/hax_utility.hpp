@@ -26,38 +26,63 @@
 #include <sstream>
 #include <vector>
 #include <iostream>
+#include <string_view>
+#include <charconv>
 
 namespace hax { namespace utility {
 
-	template<typename T>
-	inline std::string stringify(const T& x)
-	{
-		std::ostringstream o;
-		if (!(o << x))
-			throw bad_conversion(std::string("stringify(")
-								+ typeid(x).name() + ")");
-		return o.str();
-	}
-
-	// helper; converts an integer-based type to a string
-	template<typename T>
-	inline void convert(const std::string& inString, T& inValue,
-						bool failIfLeftoverChars = true)
-	{
-		std::istringstream _buffer(inString);
-		char c;
-		if (!(_buffer >> inValue) || (failIfLeftoverChars && _buffer.get(c)))
-			throw bad_conversion(inString);
-	}
-
-	template<typename T>
-	inline T convertTo(const std::string& inString,
-					   bool failIfLeftoverChars = true)
-	{
-		T _value;
-		convert(inString, _value, failIfLeftoverChars);
-		return _value;
-	}
+  /**
+   * parses the whole of in as an integer of type T into out_value; with a
+   * base of 0 the base is detected: numbers prefixed with 0x are read in hex,
+   * anything else in decimal
+   *
+   * returns false if in is not a number in the base, has trailing characters,
+   * or does not fit in T
+   **/
+  template<typename T>
+  inline bool parse_number(std::string_view in, T& out_value, int base = 0)
+  {
+    std::string_view digits = in;
+    if (base == 0)
+    {
+      base = 10;
+      if (digits.size() > 2 && digits[0] == '0' && (digits[1] | 0x20) == 'x')
+      {
+        digits.remove_prefix(2);
+        base = 16;
+      }
+    }
+
+    const char* end = digits.data() + digits.size();
+    std::from_chars_result res = std::from_chars(digits.data(), end, out_value, base);
+    return res.ec == std::errc() && res.ptr == end;
+  }
+
+  /**
+   * like the above, but raises bad_conversion if in is not a number that fits
+   * in T
+   **/
+  template<typename T>
+  inline T parse_number(std::string_view in, int base = 0)
+  {
+    T value;
+    if (!parse_number(in, value, base))
+      throw bad_conversion(string_t(in));
+
+    return value;
+  }
+
+  /**
+   * the digits of in_value in the given base (lowercase for hex), a stack
+   * buffer is enough for any integer so no stream is involved
+   **/
+  template<typename T>
+  inline std::string to_string(T in_value, int base = 10)
+  {
+    char buf[72];
+    std::to_chars_result res = std::to_chars(buf, buf + sizeof(buf), in_value, base);
+    return std::string(buf, res.ptr);
+  }
 
   /* splits a string s using the delimiter delim */
   inline static
@@ -140,7 +165,7 @@ namespace hax { namespace utility {
   }
 
   inline static
-  bool is_decimal_nr(std::string const& in)
+  bool is_decimal_nr(std::string_view in)
   {
     for (auto c : in)
       if (c < '0' || c > '9')
@@ -186,6 +211,45 @@ namespace hax { namespace utility {
     return false;
   }
 
+  /* the value of the hex digit c, or -1 if c is not a hex digit */
+  inline static
+  int hex_digit(char c)
+  {
+    if (c >= '0' && c <= '9')
+      return c - '0';
+
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+
+    return -1;
+  }
+
+  /**
+   * writes in_length bytes starting at in_data to out as pairs of uppercase
+   * hex digits, the digits are staged in a buffer so out is written to in
+   * chunks rather than a digit at a time
+   **/
+  inline static
+  void write_hex(std::ostream& out, const uint8_t* in_data, size_t in_length)
+  {
+    static const char digits[] = "0123456789ABCDEF";
+    char buf[256];
+    size_t n = 0;
+    for (size_t i = 0; i < in_length; ++i)
+    {
+      buf[n++] = digits[in_data[i] >> 4];
+      buf[n++] = digits[in_data[i] & 0x0F];
+      if (n == sizeof(buf))
+      {
+        out.write(buf, n);
+        n = 0;
+      }
+    }
+
+    out.write(buf, n);
+  }
+
   template<typename IntType>
   IntType overwrite_bits(IntType dst, IntType src, int pos, int len) {
       IntType mask = (((IntType)1 << len) - 1) << pos;
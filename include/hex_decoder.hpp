@@ -0,0 +1,65 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_hex_decoder_h
+#define h_hex_decoder_h
+
+#include "hax.hpp"
+#include <string_view>
+#include <cstdint>
+#include <vector>
+
+namespace hax
+{
+  /**
+   * decodes the digits of hex constants and literals into the bytes they denote
+   *
+   * payloads of a few bytes, which are the vast majority, are decoded one
+   * digit pair at a time, while long payloads are decoded 8 bytes at a time
+   * using SSE2 when available; both paths validate every digit and give
+   * identical results, which debug builds cross-check
+   **/
+  class hex_decoder {
+    public:
+
+    /* payloads with at least this many digit pairs are decoded in vectors */
+    static const size_t vector_threshold;
+
+    /**
+     * decodes in_hex into out, two digits a byte; an odd number of digits is
+     * read as if it were prefixed with a 0
+     *
+     * returns false if in_hex contains anything but hex digits, out is then
+     * left with unspecified content
+     **/
+    static bool decode(std::string_view in_hex, std::vector<uint8_t>& out);
+
+    /**
+     * decodes in_count pairs of hex digits starting at in_digits into the
+     * in_count bytes at out, returns false on the first invalid digit
+     **/
+    static bool decode_pairs_scalar(const char* in_digits, uint8_t* out, size_t in_count);
+    static bool decode_pairs_sse2(const char* in_digits, uint8_t* out, size_t in_count);
+
+    private:
+    hex_decoder()=delete;
+  };
+} // end of namespace
+#endif // h_hex_decoder_h
@@ -24,8 +24,12 @@
 #include "hax.hpp"
 #include "loggable.hpp"
 #include "operand.hpp"
+#include "optable.hpp"
+#include "instruction_store.hpp"
+#include "small_vector.hpp"
 #include <vector>
 #include <list>
+#include <string_view>
 
 namespace hax
 {
@@ -58,37 +62,45 @@ namespace hax
 
     /**
      * relocation records are used by the serializer to create M records:
-     * they contain the name of the symbol, plus the operation in _value_
-     * as well as the length of the field to be modified in _length_
+     * they contain the id of the symbol, whether it is added or subtracted
+     * in _negative_, as well as the length of the field to be modified in _length_
      *
-     * example:
-     *  value = +LENGTH
+     * example (M record value +LENGTH):
+     *  symbol = id of LENGTH
+     *  negative = false
      *  length = 0x06
      *
      * an instruction can have one or multiple relocation records (in case it's
-     * an expression containing multiple external symbol references)
+     * an expression containing multiple external symbol references), the
+     * usual one or two are kept inline in the instruction
      *
      * all format 4 instructions require a relocation record unless the operand
      * is addressed using immediate mode
      **/
     struct reloc_record_t {
-      string_t value;
-      uint16_t length;
+      symbol_id_t symbol;
+      uint8_t length;
+      bool negative;
     };
 
-    typedef std::list<reloc_record_t*> reloc_records_t;
+    typedef small_vector<reloc_record_t, 2> reloc_records_t;
 
     typedef addressing_mode addressing_mode_t;
 
     instruction() = delete;
-		explicit instruction(opcode_t, const string_t&, pblock_t* block);
+		explicit instruction(opcode_t, mnemonic_id_t, pblock_t* block);
     instruction(const instruction& src);
 		instruction& operator=(const instruction& rhs);
 		virtual ~instruction();
 
     opcode_t opcode() const;
+    format_t format() const;
     loc_t location() const;
-    const string_t& line() const;
+    /**
+     * the source line of this instruction, rebuilt from the source text for
+     * diagnostics and listings
+     **/
+    string_t line() const;
 
     program_block* block() const;
 
@@ -105,16 +117,16 @@ namespace hax
      * @note
      * this method will be called AFTER the label, opcode, and all operands are assigned
      **/
-    virtual void preprocess();
+    virtual status_t preprocess();
 
-    virtual void assemble()=0;
+    virtual status_t assemble()=0;
 
     /**
      * this will be called *after* this instruction has been assembled, a major
      * function that's carried out here is identifying relocatability and constructing
      * relocation records accordingly
      **/
-    virtual void postprocess();
+    virtual status_t postprocess();
 
     /**
      * the location is assigned by the program block this instruction belongs to
@@ -132,9 +144,13 @@ namespace hax
      * in_token will be passed to the operand_factory to parse its type and
      * create the correct operand object
      *
-     * an instruction can have _at most_ one operand
+     * in_flags is a combination of entry_t::flag_t bits describing the addressing
+     * mode prefix and index suffix found on the operand field by the tokenizer
+     *
+     * an instruction can have _at most_ one operand, which is left unassigned
+     * if it can not be created
      **/
-    virtual void assign_operand(string_t const& in_token);
+    virtual status_t assign_operand(std::string_view in_token, uint8_t in_flags);
     virtual void assign_operand(operand* in_operand);
 
     /**
@@ -144,10 +160,17 @@ namespace hax
      **/
     void __assign_block(program_block* block);
 
+    /**
+     * the row this instruction occupies in the instruction store of its
+     * section, assigned by instruction_store::add()
+     **/
+    void __assign_handle(instruction_store* store, instruction_store::handle_t handle);
+    instruction_store::handle_t handle() const;
+
     /**
      * the source line of this instruction (used for printing purposes)
      **/
-    void assign_line(string_t const&);
+    void assign_line(std::string_view);
 
     /**
      * is this instruction labelled?
@@ -156,6 +179,13 @@ namespace hax
     symbol_t const* const label() const;
     objcode_t objcode() const;
 
+    /**
+     * the bytes of data-bearing instructions, like BYTE directives and literals,
+     * which can be of any length and are written into the object program as
+     * they are instead of the object code word; empty for everything else
+     **/
+    virtual byte_span_t data() const;
+
     /**
      * some instructions, like the assembler directives, can't exactly be assembled
      * and do not directly produce object code, this flag tracks that attribute
@@ -167,10 +197,14 @@ namespace hax
      **/
     bool is_relocatable() const;
 
+    mnemonic_id_t mnemonic_id() const;
+
     /**
-     * convenience helper to get the literal value of its opcode
+     * convenience helper to get the literal value of its opcode, this is
+     * rebuilt from the optable on every call and is meant for listings and
+     * error messages only, see mnemonic_id() for everything else
      **/
-    string_t const& mnemonic() const;
+    virtual string_t mnemonic() const;
 
     /**
      * @note
@@ -196,18 +230,15 @@ namespace hax
      * then it creates the necessary reloc_record objects which will be later
      * used by the serializer to create M records
      */
-    void construct_relocation_records();
+    status_t construct_relocation_records();
 
-    reloc_record_t* construct_relocation_record(symbol_t* sym);
+    reloc_record_t construct_relocation_record(symbol_id_t sym, bool negative = false) const;
 
     /* the opcode is automatically set when the instruction is created by looking
      * up the mnemonic code in the master optable
      */
     opcode_t opcode_;
 
-    /* the location is assigned in pass 1 and critical required for assembling */
-    loc_t location_;
-
     /* the length in bytes of this instruction's assembly output */
     size_t length_;
 
@@ -221,9 +252,10 @@ namespace hax
     /* see instruction::addressing_mode above */
     uint32_t addr_mode_;
 
-    /* the source line from which this instruction was created,
-     * used only for printing purposes */
-    string_t line_;
+    /* the source line from which this instruction was created, used only for
+     * printing purposes; it refers to the source text which is retained by the
+     * source reader until the sections are released */
+    std::string_view line_;
 
     /* this is the value that will contain the output of the assembly */
     objcode_t objcode_;
@@ -231,8 +263,8 @@ namespace hax
     /* indexed instructions have their x bit set to 1 in the targeting flags */
     bool indexed_;
 
-    /* the literal representation of the opcode */
-    string_t mnemonic_;
+    /* the optable entry this instruction was created from */
+    mnemonic_id_t mnemonic_id_;
 
     /* used only for printing purposes */
     uint8_t objcode_width_;
@@ -243,6 +275,11 @@ namespace hax
 
     reloc_records_t reloc_recs_;
 
+    /* the location is assigned in pass 1 and critically required for
+     * assembling, it is kept in the instruction store of the section */
+    instruction_store* store_;
+    instruction_store::handle_t handle_;
+
     private:
 	};
 
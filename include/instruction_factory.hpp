@@ -28,6 +28,7 @@
 #include "fmt3_instruction.hpp"
 #include "fmt4_instruction.hpp"
 #include "directive.hpp"
+#include "tokenizer.hpp"
 
 namespace hax
 {
@@ -42,31 +43,30 @@ namespace hax
     /**
      * @brief
      * creates a new instruction instance of the correct type based on the format
-     * of the given opcode:
+     * of the given entry's opcode, and assigns it to out_inst:
      *
      *  1. format 1: creates an instance of fmt1_instruction
      *  2. format 2: creates an instance of fmt2_instruction
      *  3. format 3/4: creates an instance of either fmt3_instruction or fmt4_instruction[1]
      *  4. directive: creates an assembler directive instance
      *
-     * this method can throw an exception of type hax::unrecognized_operation()
-     * if no registered operations could be found with the given id
+     * this method fails with hax::unrecognized_operation() if no registered
+     * operations could be found with the given id
      *
      * @note
-     * [1] when the operation could belong to either format 3 or format 4, the token
-     *     is scanned for the prefix '+' that denotes if it's an extended format
-     *     instruction or not
+     * [1] when the operation could belong to either format 3 or format 4, the entry
+     *     is checked for the entry_t::f_extended flag which the tokenizer raises
+     *     when the mnemonic is prefixed by '+'
      *
      * @note
      * literals are not created by the factory, nor should they be, they are
      * handled internally by the symbol manager as are symbols
      *
      * @warning
-     * the instruction factory does not retain ownership of newly created instances,
-     * it is the responsibility of the caller to free the allocated objects except
-     * for in the case of symbols where ownership belongs to the symbol_manager
+     * instructions are created in the arena of the control section in_block
+     * belongs to, which owns them; they must not be freed explicitly
      **/
-    instruction_t* create(string_t const& opcode_token, program_block *in_block);
+    status_t create(entry_t const& in_entry, program_block *in_block, instruction_t*& out_inst);
 
     private:
     static instruction_factory *__instance;
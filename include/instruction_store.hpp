@@ -0,0 +1,127 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_instruction_store_h
+#define h_instruction_store_h
+
+#include "hax.hpp"
+#include "optable.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace hax
+{
+  class instruction;
+  class operand;
+  typedef instruction instruction_t;
+  typedef operand operand_t;
+
+  /**
+   * the instructions of a control section laid out as a structure of arrays:
+   * every hot field that the passes and the serializer walk over lives in
+   * its own contiguous column, and row i of every column describes the i-th
+   * instruction of the section in source order
+   *
+   * the instruction objects themselves remain the side table for the rarely
+   * touched (cold) state, like the label, the source line and the relocation
+   * records, as well as the format-specific behaviour
+   *
+   * the location column is the authority on the address of an instruction,
+   * the remaining columns are recorded from the instruction objects at the
+   * end of each pass, see record_pass1() and record_pass2()
+   **/
+  class instruction_store {
+    public:
+
+    typedef uint32_t handle_t;
+
+    enum flag_t : uint8_t {
+      f_labelled    = 0x01,
+      f_assemblable = 0x02,
+      f_relocatable = 0x04,
+      /* the object code is the data() of the instruction, see instruction::data() */
+      f_data        = 0x08
+    };
+
+    /* the handle of instructions that are not in a store */
+    static const handle_t nil;
+
+    instruction_store();
+    virtual ~instruction_store();
+
+    instruction_store(const instruction_store& src)=delete;
+    instruction_store& operator=(const instruction_store& rhs)=delete;
+
+    /**
+     * appends a row for in_inst in the program block identified by in_block
+     * and hands the instruction its handle, the row is located at 0 until
+     * the instruction is assigned a location
+     **/
+    handle_t add(instruction_t* in_inst, uint16_t in_block);
+
+    /**
+     * records the mnemonic, format, length, operand and flags of the
+     * instruction at in_handle once it has been preprocessed and laid out
+     **/
+    void record_pass1(handle_t in_handle);
+
+    /**
+     * records the object code and relocatability of the instruction at
+     * in_handle once it has been assembled and postprocessed
+     **/
+    void record_pass2(handle_t in_handle);
+
+    /**
+     * shifts the location of every instruction by the address assigned to
+     * its program block in in_offsets (indexed by block id) in one pass over
+     * the store, labelled instructions redefine their label symbols
+     **/
+    void relocate(std::vector<loc_t> const& in_offsets);
+
+    size_t size() const { return instructions_.size(); }
+    bool empty() const { return instructions_.empty(); }
+
+    instruction_t* instruction_at(handle_t i) const { return instructions_[i]; }
+    mnemonic_id_t mnemonic_id(handle_t i) const { return mnemonic_ids_[i]; }
+    format_t format(handle_t i) const { return formats_[i]; }
+    uint8_t flags(handle_t i) const { return flags_[i]; }
+    bool has(handle_t i, flag_t in_flag) const { return (flags_[i] & in_flag) != 0; }
+    loc_t location(handle_t i) const { return locations_[i]; }
+    loc_t length(handle_t i) const { return lengths_[i]; }
+    operand_t* operand_at(handle_t i) const { return operands_[i]; }
+    objcode_t objcode(handle_t i) const { return objcodes_[i]; }
+
+    void assign_location(handle_t i, loc_t in_loc) { locations_[i] = in_loc; }
+    void assign_objcode(handle_t i, objcode_t in_objcode) { objcodes_[i] = in_objcode; }
+
+    protected:
+
+    std::vector<instruction_t*> instructions_;
+    std::vector<mnemonic_id_t> mnemonic_ids_;
+    std::vector<format_t> formats_;
+    std::vector<uint8_t> flags_;
+    std::vector<uint16_t> blocks_;
+    std::vector<loc_t> locations_;
+    std::vector<loc_t> lengths_;
+    std::vector<operand_t*> operands_;
+    std::vector<objcode_t> objcodes_;
+  };
+} // end of namespace
+#endif // h_instruction_store_h
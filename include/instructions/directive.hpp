@@ -29,20 +29,31 @@ namespace hax
     public:
 
     directive() = delete;
-		explicit directive(opcode_t, string_t const& in_mnemonic, pblock_t* block);
+		explicit directive(opcode_t, mnemonic_id_t, pblock_t* block);
     directive(const directive& src);
 		directive& operator=(const directive& rhs);
 		virtual ~directive();
 
     virtual loc_t length() const;
-    virtual void assemble();
+    virtual status_t assemble();
     virtual bool is_valid() const;
-    virtual void preprocess();
+    virtual status_t preprocess();
+
+    /* the bytes of a hex or ASCII BYTE constant */
+    virtual byte_span_t data() const;
+
+    /**
+     * assigns the value of the operand of an EQU directive to its label, this
+     * is done right away unless the operand refers to symbols that are not
+     * defined yet, see symbol_manager::resolve_definitions()
+     *
+     * fails if the operand can not be evaluated
+     **/
+    status_t __define();
 
     protected:
     void copy_from(const directive&);
 
-    string_t op_;
 
     private:
 	};
@@ -29,13 +29,13 @@ namespace hax
     public:
 
     fmt1_instruction() = delete;
-		explicit fmt1_instruction(opcode_t, const string_t&, pblock_t* block);
+		explicit fmt1_instruction(opcode_t, mnemonic_id_t, pblock_t* block);
     fmt1_instruction(const fmt1_instruction& src);
 		fmt1_instruction& operator=(const fmt1_instruction& rhs);
 		virtual ~fmt1_instruction();
 
     virtual loc_t length() const;
-    virtual void assemble();
+    virtual status_t assemble();
     virtual bool is_valid() const;
 
     protected:
@@ -29,16 +29,16 @@ namespace hax
     public:
 
     fmt2_instruction() = delete;
-		explicit fmt2_instruction(opcode_t, const string_t&, pblock_t* block);
+		explicit fmt2_instruction(opcode_t, mnemonic_id_t, pblock_t* block);
     fmt2_instruction(const fmt2_instruction& src);
 		fmt2_instruction& operator=(const fmt2_instruction& rhs);
 		virtual ~fmt2_instruction();
 
     virtual loc_t length() const;
-    virtual void assemble();
+    virtual status_t assemble();
     virtual bool is_valid() const;
 
-    void assign_operand(string_t const& in_token);
+    status_t assign_operand(std::string_view in_token, uint8_t in_flags);
 
     protected:
     void copy_from(const fmt2_instruction&);
@@ -22,6 +22,7 @@
 #define h_fmt3_instruction_h
 
 #include "instruction.hpp"
+#include "encoders.hpp"
 
 namespace hax
 {
@@ -29,7 +30,7 @@ namespace hax
     public:
 
 		fmt3_instruction() = delete;
-		explicit fmt3_instruction(opcode_t, const string_t&, pblock_t* block);
+		explicit fmt3_instruction(opcode_t, mnemonic_id_t, pblock_t* block);
     fmt3_instruction(const fmt3_instruction& src);
 		fmt3_instruction& operator=(const fmt3_instruction& rhs);
 		virtual ~fmt3_instruction();
@@ -42,20 +43,39 @@ namespace hax
      *  2. indirect
      *  3. simple
      **/
-    virtual void assign_operand(string_t const&);
+    virtual status_t assign_operand(std::string_view, uint8_t);
 
     virtual loc_t length() const;
-    virtual void assemble();
+
+    /**
+     * encodes this instruction on its own through a batch of one, sections
+     * gather all of theirs into a single batch instead
+     **/
+    virtual status_t assemble();
     virtual bool is_valid() const;
 
-    virtual void preprocess();
+    virtual status_t preprocess();
+
+    /**
+     * the batched counterpart of assemble(): evaluates the operand and queues
+     * this instruction in out_batch, control_section::assemble() later hands
+     * the encoded result back through assign_objcode()
+     **/
+    status_t gather(encoding::fmt3_batch& out_batch);
+
+    /**
+     * fails with target_out_of_bounds if in_objcode is encoding::out_of_bounds
+     **/
+    status_t assign_objcode(objcode_t in_objcode, int in_target);
 
     protected:
     void copy_from(const fmt3_instruction&);
 
-    bool pc_relative_viable(int& address) const;
-    bool base_relative_viable(int& address) const;
-    bool immediate_viable(int& address) const;
+    /* evaluates the operand and assigns the address, or value, to target */
+    status_t evaluate_target(int& out_target);
+
+    /* whether the target is the address of the symbol operand rather than its value */
+    bool by_address_;
 
     private:
 	};
@@ -22,6 +22,7 @@
 #define h_fmt4_instruction_h
 
 #include "instruction.hpp"
+#include "encoders.hpp"
 
 namespace hax
 {
@@ -29,20 +30,23 @@ namespace hax
     public:
 
     fmt4_instruction() = delete;
-		explicit fmt4_instruction(opcode_t, const string_t&, pblock_t* block);
+		explicit fmt4_instruction(opcode_t, mnemonic_id_t, pblock_t* block);
     fmt4_instruction(const fmt4_instruction& src);
 		fmt4_instruction& operator=(const fmt4_instruction& rhs);
 		virtual ~fmt4_instruction();
 
     virtual loc_t length() const;
-    virtual void assemble();
+    virtual status_t assemble();
     virtual bool is_valid() const;
 
-    void assign_operand(string_t const& in_operand);
+    status_t assign_operand(std::string_view in_operand, uint8_t in_flags);
 
     protected:
     void copy_from(const fmt4_instruction&);
 
+    /* see encoding::select_fmt4(), 0 if the addressing mode is invalid */
+    encoding::encoder_t encoder_;
+
     private:
 	};
 } // end of namespace
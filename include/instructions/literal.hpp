@@ -31,14 +31,24 @@ namespace hax
     typedef std::list<operand*> deps_t;
 
     literal() = delete;
-		explicit literal(string_t const& in_value, pblock_t* block);
+    /**
+     * in_value refers to the literal in the source text and is not copied
+     **/
+		explicit literal(std::string_view in_value, pblock_t* block);
     literal(const literal& src);
 		literal& operator=(const literal& rhs);
 		virtual ~literal();
 
     virtual loc_t length() const;
-    virtual void preprocess();
-    virtual void assemble();
+    virtual status_t preprocess();
+    virtual status_t assemble();
+    virtual byte_span_t data() const;
+
+    /**
+     * literals are not in the optable, their mnemonic is the literal itself
+     * as it appears in the source, e.g. =C'EOF'
+     **/
+    virtual string_t mnemonic() const;
 
     void add_dependency(operand*);
     deps_t& dependencies();
@@ -47,8 +57,11 @@ namespace hax
 
     protected:
     deps_t deps_;
+    std::string_view value_;
     bool is_ascii_;
-    string_t stripped_;
+    std::string_view stripped_;
+    std::vector<uint8_t> decoded_;
+    byte_span_t bytes_;
     bool assembled_;
 
     void copy_from(const literal&);
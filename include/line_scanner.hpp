@@ -0,0 +1,112 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_line_scanner_h
+#define h_line_scanner_h
+
+#include "hax.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace hax
+{
+  /**
+   * the layout of a single source line as found by the line_scanner, all
+   * offsets are relative to the beginning of the scanned block
+   *
+   * a field is a run of characters delimited by spaces, tabs, or the line
+   * boundaries, and nothing that follows a comment marker ('.' or ';') is
+   * considered part of any field
+   *
+   * spaces, tabs and comment markers that are enclosed in quotes, as in the
+   * operand C'HELLO WORLD', are part of the field; a quote that is not closed
+   * extends to the end of its line
+   **/
+  struct scanned_line_t {
+    enum { max_fields = 3 };
+
+    struct field_t {
+      size_t begin;
+      size_t end;
+    };
+
+    /* the first character of the first field */
+    size_t begin;
+
+    /* one past the last character of the last field */
+    size_t end;
+
+    /* the total number of fields in the line, only the first max_fields of
+     * which are tracked */
+    uint32_t nr_fields;
+
+    field_t fields[max_fields];
+
+    bool operator==(scanned_line_t const& rhs) const;
+  };
+
+  /**
+   * finds the newline, comment and field boundaries of a whole block of input
+   * in a single pass
+   *
+   * the block is processed 64 bytes at a time: the newline, comment and
+   * whitespace bytes of every chunk are first gathered into bitmasks using
+   * SSE2 (or AVX2 when the CPU supports it) compares, then only the positions
+   * where the masks change are visited to build the per-line field offsets
+   *
+   * a scalar implementation is used on hosts without SSE2, and serves as the
+   * reference the vectorized paths must agree with; debug builds cross-check
+   * every scanned block against it, and the line_scanner test compares all
+   * three over the fixtures and generated input
+   **/
+  class line_scanner {
+    public:
+    typedef std::vector<scanned_line_t> lines_t;
+
+    /**
+     * appends a record for every line in the block [in_data, in_data+in_size)
+     * that contains at least one field to out_lines, lines that are blank or
+     * hold nothing but a comment are skipped
+     *
+     * a trailing line that is not terminated by a newline is treated as a
+     * complete line
+     **/
+    static void scan(const char* in_data, size_t in_size, lines_t& out_lines);
+
+    static void scan_scalar(const char* in_data, size_t in_size, lines_t& out_lines);
+    static void scan_sse2(const char* in_data, size_t in_size, lines_t& out_lines);
+    static void scan_avx2(const char* in_data, size_t in_size, lines_t& out_lines);
+
+    /**
+     * whether the respective vectorized implementation is usable on this host
+     **/
+    static bool has_sse2();
+    static bool has_avx2();
+
+    /**
+     * name of the implementation picked by line_scanner::scan()
+     **/
+    static const char* isa();
+
+    private:
+    line_scanner()=delete;
+  };
+} // end of namespace
+#endif // h_line_scanner_h
@@ -23,6 +23,7 @@
 
 #include "hax.hpp"
 #include "loggable.hpp"
+#include <string_view>
 
 namespace hax
 {
@@ -40,7 +41,7 @@ namespace hax
   class operand : public loggable {
     public:
 
-		explicit operand(string_t const& in_token, instruction* in_inst);
+		explicit operand(std::string_view in_token, instruction* in_inst);
     operand()=delete;
     operand(const operand& src);
 		operand& operator=(const operand& rhs);
@@ -49,12 +50,18 @@ namespace hax
     /**
      * attempts to produce the value of this operand, the result can be tested
      * by calling operand::is_evaluated()
+     *
+     * fails if the value can not be produced from the input program
      **/
-    virtual void evaluate()=0;
+    virtual status_t evaluate()=0;
 
     virtual uint32_t value() const;
-    virtual string_t const& token() const;
-    uint16_t length() const;
+    /**
+     * the operand as it appears in the source, this refers to the source text
+     * and is not a copy of it
+     **/
+    virtual std::string_view token() const;
+    loc_t length() const;
 
     bool is_evaluated() const;
 
@@ -84,10 +91,10 @@ namespace hax
       t_literal
     };
 
-    string_t token_;
+    std::string_view token_;
     uint32_t value_;
     char type_;
-    uint16_t length_;
+    loc_t length_;
 
     instruction* inst_;
 
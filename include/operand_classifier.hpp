@@ -0,0 +1,98 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_operand_classifier_h
+#define h_operand_classifier_h
+
+#include "hax.hpp"
+#include <string_view>
+#include <cstdint>
+
+namespace hax
+{
+  /**
+   * the result of classifying an operand token, the payload is the part of
+   * the token that carries the operand's value:
+   *
+   *  1. the digits of a decimal constant
+   *  2. the characters between the quotes of hex and ASCII constants and literals
+   *  3. the '*' of the location counter operator
+   *  4. the whole token of symbols and expressions
+   *
+   * offsets are relative to the classified token and never include the
+   * addressing mode prefix (# or @)
+   **/
+  struct operand_class_t {
+    enum kind_t : uint8_t {
+      k_decimal = 0,
+      k_hex_constant,   // X'hexdigits'
+      k_ascii_constant, // C'characters'
+      k_hex_literal,    // =X'hexdigits'
+      k_ascii_literal,  // =C'characters'
+      k_current_loc,    // *
+      k_symbol,
+      k_expression
+    };
+
+    kind_t kind;
+
+    /* the length of the addressing mode prefix, 0 or 1 */
+    uint8_t prefix;
+
+    size_t payload_begin;
+    size_t payload_end;
+
+    bool is_constant() const { return kind <= k_current_loc; }
+    bool is_literal() const { return kind == k_hex_literal || kind == k_ascii_literal; }
+
+    std::string_view payload(std::string_view in_token) const {
+      return in_token.substr(payload_begin, payload_end - payload_begin);
+    }
+  };
+
+  /**
+   * classifies operand tokens by walking them once against a character table,
+   * the classification rules are:
+   *
+   *  1. tokens beginning with C' or X' are ASCII or hex constants
+   *  2. tokens beginning with =C' or =X' are ASCII or hex literals
+   *  3. tokens beginning with * denote the location counter
+   *  4. tokens made up only of digits are decimal constants
+   *  5. tokens containing any operator character are expressions
+   *  6. anything else is a symbol
+   *
+   * a leading addressing mode flag (# or @) is skipped before classifying
+   **/
+  class operand_classifier {
+    public:
+
+    static operand_class_t classify(std::string_view in_token);
+
+    /**
+     * shortcut used for the terms of expressions, which carry no addressing
+     * mode flags
+     **/
+    static bool is_symbol(std::string_view in_token);
+
+    private:
+    operand_classifier()=delete;
+  };
+} // end of namespace
+#endif // h_operand_classifier_h
@@ -25,6 +25,7 @@
 #include "operands/constant.hpp"
 #include "operands/expression.hpp"
 #include "operands/symbol.hpp"
+#include <string_view>
 
 namespace hax
 {
@@ -40,36 +41,16 @@ namespace hax
     /**
      * @brief
      * creates a new operand instance of the correct type based on the format
-     * of the given token
+     * of the given token, see operand_classifier for the formats, and assigns
+     * it to out_operand
+     *
+     * fails if the token is a malformed expression or constant
      *
      * @warning
-     * the operand factory does not retain ownership of newly created instances,
-     * it is the responsibility of the caller to free the allocated objects
-     **/
-    operand_t* create(string_t const& opcode_token, instruction* in_inst);
-
-    /**
-     * constants begin with:
-     *  1. a number
-     *  2. C' to denote an ASCII constant, or
-     *  3. X' to denote a hexadecimal constant
-     **/
-    bool __is_constant(string_t const& token);
-
-    /**
-     * literals must begin with either =C' or =X'
-     **/
-    bool __is_literal(string_t const& token);
-
-    /**
-     * symbol names must begin with a character, and can not contain any operator character
-     **/
-    bool __is_symbol(string_t const& token);
-
-    /**
-     * tokens that contain any operators are taken to be expressions
+     * operands are created in the arena of in_inst's control section, which
+     * owns them; they must not be freed explicitly
      **/
-    bool __is_expression(string_t const& token);
+    status_t create(std::string_view in_token, instruction* in_inst, operand_t*& out_operand);
 
     private:
     static operand_factory *__instance;
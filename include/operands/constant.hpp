@@ -23,6 +23,7 @@
 
 #include "hax.hpp"
 #include "operand.hpp"
+#include "operand_classifier.hpp"
 
 namespace hax
 {
@@ -34,19 +35,18 @@ namespace hax
     public:
 
     /**
-     * The type of this constant is deduced in the constructor by checking
-     * the passed token for occurences of every format specification. If the token
-     * includes:
+     * The type of this constant is given by in_class, as classified by the
+     * operand_classifier:
      *
-     *  1. C'' then it is assumed to be an ASCII constant
-     *  2. X'' then it is assumed to be a hexadecimal constant
-     *  3. =C'' then it is assumed to be an ASCII literal
-     *  4. =X'' then it is assumed to be a hexadecimal literal
-     *  5. * then it is assumed to be the special location operator
-     *  6. /(#)*[0-9]/ then it is assumed to be a decimal constant
+     *  1. C'' is an ASCII constant
+     *  2. X'' is a hexadecimal constant
+     *  3. =C'' is an ASCII literal
+     *  4. =X'' is a hexadecimal literal
+     *  5. * is the special location operator
+     *  6. /(#)*[0-9]/ is a decimal constant
      *
      **/
-		explicit constant(string_t const& in_token, instruction* in_inst);
+		explicit constant(std::string_view in_token, instruction* in_inst, operand_class_t const& in_class);
     constant()=delete;
     constant(const constant& src);
 		constant& operator=(const constant& rhs);
@@ -55,27 +55,68 @@ namespace hax
     /**
      * Calculates the value of this constant.
      *
-     * For Hex and ASCII constants, the value is extracted from the token and
-     * converted one byte at a time into its internal hexadecimal representation.
+     * For Hex and ASCII constants, the token is decoded into its bytes, see
+     * bytes(), and the value is the trailing word of them.
      *
      * For all literals, the value is simply the location of the assigned literal.
      *
      * For the special operator *, the location counter of the program block of
      * this operand's instruction is used.
      **/
-    virtual void evaluate();
+    virtual status_t evaluate();
+
+    /**
+     * evaluates this constant once and for all, and flags it as shared by
+     * several instructions: later calls to evaluate() are no-ops
+     *
+     * fails, leaving the constant unshared, if it can not be evaluated
+     *
+     * @note
+     * this is called by the constant_pool which owns shared constants
+     **/
+    status_t __share();
+
+    bool is_shared() const;
+
+    /**
+     * the bytes of a hex or ASCII constant, empty for any other kind
+     *
+     * the bytes stay valid for as long as this constant is alive
+     **/
+    byte_span_t bytes() const;
+
+    /**
+     * assigns the bytes denoted by the payload of a hex or ASCII constant or
+     * literal to out_bytes: ASCII payloads are their own bytes, while hex
+     * payloads are decoded into out_decoded which then holds them
+     *
+     * fails with invalid_operand if a hex payload contains anything but hex
+     * digits, in_line is the offending source line
+     **/
+    static status_t decode(std::string_view in_payload,
+                           bool in_ascii,
+                           string_t const& in_line,
+                           std::vector<uint8_t>& out_decoded,
+                           byte_span_t& out_bytes);
+
+    /* the trailing (at most 4) bytes of in_bytes packed into a word */
+    static objcode_t fold(byte_span_t in_bytes);
 
     protected:
-    void (constant::*handler_)();
+    status_t (constant::*handler_)();
+
+    status_t handle_ascii_constant();
+    status_t handle_hex_constant();
+    status_t handle_hex_or_ascii_constant(bool is_ascii);
+    status_t handle_constant();
+    status_t handle_current_loc();
+    status_t handle_literal();
 
-    void handle_ascii_constant();
-    void handle_hex_constant();
-    void handle_hex_or_ascii_constant(bool is_ascii);
-    void handle_constant();
-    void handle_current_loc();
-    void handle_literal();
+    std::string_view stripped_;
+    std::vector<uint8_t> decoded_;
+    byte_span_t bytes_;
 
-    string_t stripped_;
+    bool shared_;
 
     void copy_from(const constant&);
 	};
@@ -23,68 +23,153 @@
 
 #include "hax.hpp"
 #include "operand.hpp"
-#include <map>
-#include <list>
+#include "small_vector.hpp"
+#include <vector>
 
 namespace hax
 {
   class symbol;
+  class symbol_manager;
   typedef symbol symbol_t;
 
   /**
-   * Expressions can contain already defined symbols, decimal constants, and any
-   * of the following operators:
-   *  + - * / ( )
+   * Expressions can contain symbols, decimal constants, and any of the
+   * following operators:
+   *  + - * / % ( )
    *
-   * An expression which contains a term that is an external reference will not
-   * be evaluated.
+   * where - and + may also be used as unary signs.
+   *
+   * An expression is compiled once when it is created into a postfix program
+   * whose terms are numbers or the ids of symbols, it can then be evaluated
+   * any number of times without touching the source text or allocating.
+   * Operations on numbers alone are folded while compiling, so 3*4 becomes 12.
+   * Symbols are never folded, not even those EQU defines as constants: the
+   * value of a symbol is only final once the program blocks are relocated,
+   * so TABLE+3*ENTRYLEN keeps its multiplication.
    **/
   class expression : public operand {
     public:
-    typedef std::map<char, int> weights_t;
-    typedef std::list<symbol_t*> extrefs_t;
-    static weights_t operator_weights;
+    typedef std::vector<symbol_t*> extrefs_t;
+
+    /**
+     * an instruction of the compiled program, which runs over a stack of
+     * integers; the position is the offset of the term or operator in the
+     * token, used to point at the culprit when evaluation fails
+     **/
+    struct op_t {
+      enum code_t : uint8_t {
+        o_number,   // pushes arg
+        o_symbol,   // pushes the value of the symbol whose id is arg
+        o_negate,
+        o_add,
+        o_subtract,
+        o_multiply,
+        o_divide,
+        o_modulo
+      };
+
+      code_t code;
+      uint16_t position;
+      uint32_t arg;
+    };
+
+    typedef small_vector<op_t, 4> program_t;
 
     /**
-     * When an expression is created, the given token is attempted to be converted
-     * into postfix notation, and tracks every symbolic term referenced in the
-     * expression body.
+     * a relocatable term of the expression: the external reference whose id
+     * is symbol, added weight times, or subtracted when weight is negative
      **/
-		explicit expression(string_t const& in_token, instruction* in_inst);
+    struct term_t {
+      symbol_id_t symbol;
+      int32_t weight;
+    };
+
+    typedef small_vector<term_t, 2> terms_t;
+
+    /* the deepest a program may grow the stack, and parentheses be nested */
+    static constexpr size_t max_depth = 64;
+
+		explicit expression(std::string_view in_token, instruction* in_inst);
     expression()=delete;
     expression(const expression& src);
 		expression& operator=(const expression& rhs);
 		virtual ~expression();
 
     /**
-     * Substitutes every reference defined in the expression body with its
-     * actual value, then attempts to calculate the value of the postfix expression.
+     * Compiles the token and declares every symbol it references, this must be
+     * done once before the expression is evaluated.
+     *
+     * fails with invalid_expression if the token is malformed, the message
+     * points at the offending position
+     **/
+    status_t compile();
+
+    /**
+     * Runs the compiled program against the current values of the referenced
+     * symbols; the result is memoized until the symbol table moves on to
+     * another epoch, see symbol_manager::epoch().
      *
      * References to symbols must be fully evaluated before attempting to evaluate
-     * an expression, otherwise an exception of type hax::unevaluated_operand()
-     * will be thrown.
+     * an expression, otherwise it fails with hax::unevaluated_operand().
      **/
-    virtual void evaluate();
+    virtual status_t evaluate();
 
+    /**
+     * every symbol term of the expression, in the order they appear in
+     **/
     extrefs_t& references();
 
+    program_t const& program() const;
+
+    /**
+     * works out the sign of every external reference from the compiled program
+     * in a single pass, and assigns the terms that are left once references
+     * that cancel each other out, like EXT-EXT, are dropped
+     *
+     * symbols defined in the section are absolute as far as the object program
+     * is concerned and yield no terms
+     *
+     * fails with invalid_expression if an external reference that does not cancel
+     * out is multiplied, divided, or used as a divisor
+     **/
+    status_t relocation_terms(terms_t& out_terms) const;
+
+    /**
+     * flags this expression as shared by several instructions, it is then no
+     * longer tied to the instruction it was created for
+     *
+     * @note
+     * this is called by the expression_pool which owns shared expressions
+     **/
+    void __share();
+
+    bool is_shared() const;
+
+    /**
+     * carries out the binary operation in_code, or negation of in_rhs, in
+     * 64 bits and wraps the result into a word; the caller rules out
+     * division by zero
+     **/
+    static int32_t apply(op_t::code_t in_code, int32_t in_lhs, int32_t in_rhs);
+
     protected:
     void copy_from(const expression&);
-    int evaluate_postfix(string_t in_expr/*, std::vector<string_t> in_operands*/);
 
     /**
-     * converts an infix expression into a postfix one
+     * a failed status of invalid_expression with in_msg, pointing at in_position
+     * of the token
      **/
-    void to_postfix(string_t const& in, string_t &out);
-    bool has_precedence(char op1, char op2);
-    int apply_operator(char op, int lhs, int rhs);
+    status_t __fail(string_t const& in_msg, size_t in_position) const;
 
+    program_t program_;
     extrefs_t extrefs_;
+    symbol_manager* symbols_;
 
-    string_t postfix_expr_;
-
-    bool absolute_;
+    /* the epoch of the symbol table the value was last evaluated in */
+    uint32_t epoch_;
+    bool shared_;
 
+    friend class expression_compiler;
 	};
 
   typedef expression expression_t;
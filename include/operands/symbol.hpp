@@ -37,7 +37,11 @@ namespace hax
   class symbol : public operand {
     public:
 
-		explicit symbol(string_t const& in_label, instruction* in_inst=0);
+    /**
+     * in_label must outlive the symbol, the symbol manager hands out the
+     * name interned in the section's arena
+     **/
+		explicit symbol(std::string_view in_label, symbol_id_t in_id, instruction* in_inst=0);
     symbol()=delete;
     symbol(const symbol& src);
 		symbol& operator=(const symbol& rhs);
@@ -46,7 +50,12 @@ namespace hax
     /**
      * nothing to evaluate here, symbols have their values/addresses externally
      **/
-    virtual void evaluate();
+    virtual status_t evaluate();
+
+    /**
+     * the id of this symbol's name in the symbol table of its section
+     **/
+    symbol_id_t id() const;
 
     /**
      * sets the address of this symbol equal to in_address, effectively "evaluating" it
@@ -72,6 +81,13 @@ namespace hax
      **/
     void set_user_defined(bool f);
 
+    /**
+     * marks this symbol as not defined yet, this is done for the labels of EQU
+     * directives whose definition is deferred until their operand is resolved,
+     * see symbol_manager::defer_definition()
+     **/
+    void __withdraw();
+
     bool is_user_defined() const;
 
     /**
@@ -93,6 +109,7 @@ namespace hax
 
     protected:
 
+    symbol_id_t id_;
     loc_t address_;
     bool user_defined_;
     bool external_ref_;
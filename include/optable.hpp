@@ -0,0 +1,148 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_optable_h
+#define h_optable_h
+
+#include "hax.hpp"
+#include <cstdint>
+#include <string_view>
+
+namespace hax
+{
+  /**
+   * dense IDs of the mnemonics registered in the optable, in the order they
+   * are listed in; instructions carry the ID so that handling a particular
+   * mnemonic never needs a string comparison
+   **/
+  enum mnemonic_id_t : uint8_t {
+    m_add = 0,
+    m_addr,
+    m_and,
+    m_clear,
+    m_comp,
+    m_compr,
+    m_div,
+    m_divr,
+    m_hio,
+    m_j,
+    m_jeq,
+    m_jgt,
+    m_jlt,
+    m_jsub,
+    m_lda,
+    m_ldb,
+    m_ldch,
+    m_ldf,
+    m_ldl,
+    m_lds,
+    m_ldt,
+    m_ldx,
+    m_mul,
+    m_or,
+    m_rd,
+    m_rsub,
+    m_shiftl,
+    m_shiftr,
+    m_sio,
+    m_sta,
+    m_stb,
+    m_stch,
+    m_sti,
+    m_stl,
+    m_sts,
+    m_stsw,
+    m_stt,
+    m_stx,
+    m_sub,
+    m_subr,
+    m_td,
+    m_tio,
+    m_tix,
+    m_tixr,
+    m_wd,
+
+    /* assembler directives */
+    m_start,
+    m_csect,
+    m_end,
+    m_extref,
+    m_extdef,
+    m_use,
+    m_equ,
+    m_resw,
+    m_resb,
+    m_byte,
+    m_word,
+    m_org,
+    m_ltorg,
+    m_base,
+    m_current_loc, // *
+
+    /* literal pool entries are not in the optable, they all share this ID */
+    m_literal,
+    m_undefined
+  };
+
+  /**
+   * an entry in the master table of SIC/XE operations and assembler directives
+   **/
+  struct op_t {
+    std::string_view mnemonic;
+    mnemonic_id_t id;
+    opcode_t code;
+
+    /* one of hax::format, operations that can be extended are fmt_three | fmt_four */
+    format_t fmt;
+  };
+
+  /**
+   * the master table of SIC/XE operations and assembler directives
+   *
+   * the table is generated at compile time from a single list of mnemonics
+   * into a perfect hash, so a lookup costs one hash and at most one compare;
+   * tokens that can not possibly be mnemonics (like most labels) are rejected
+   * by their length and first character before any hashing is done
+   **/
+  class optable {
+    public:
+
+    /**
+     * returns the entry registered for in_mnemonic, or 0 if there is none
+     *
+     * @note
+     * in_mnemonic must be stripped of the '+' prefix of extended operations
+     **/
+    static const op_t* find(std::string_view in_mnemonic);
+
+    /**
+     * returns the entry registered for in_id, which must be a mnemonic in the
+     * optable (so not m_literal or m_undefined)
+     **/
+    static const op_t& get(mnemonic_id_t in_id);
+
+    /* the number of registered operations and directives */
+    static size_t size();
+
+    private:
+    optable()=delete;
+  };
+} // end of namespace
+#endif // h_optable_h
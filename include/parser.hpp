@@ -25,9 +25,9 @@
 #include "instruction.hpp"
 //~ #include "program_block.hpp"
 #include "control_section.hpp"
-#include <map>
 #include <list>
 #include <tuple>
+#include <string_view>
 
 namespace hax
 {
@@ -46,15 +46,8 @@ namespace hax
 
     void process(string_t const& in, string_t const& out);
 
-    /**
-     * looks up the opcode table for the given mnemonic token, if the op was not
-     * found to be registered, ec will be set to 1, otherwise the opcode is returned
-     * and ec is set to 0
-     **/
-    opcode_fmt_t opcode_from_token(string_t const&, int* ec);
-
-    bool is_op(string_t const& token) const;
-    bool is_directive(string_t const& token) const;
+    bool is_op(std::string_view token) const;
+    bool is_directive(std::string_view token) const;
 
     loc_t base() const;
     void set_base(loc_t in_loc);
@@ -81,8 +74,20 @@ namespace hax
     csect_t* sect() const;
 
     void track_error(hax_error& err);
+
+    /**
+     * tracks the error held by in_status if it failed, returns whether it did
+     * not, see status_t
+     **/
+    bool track_error(status_t const& in_status);
     void report_errors() const;
 
+    /**
+     * destroys every registered control section, this is done once the
+     * object program has been written
+     **/
+    void release_sections();
+
     /**
      * assigns the block identified by in_name to be the currently used one in
      * the current control section
@@ -96,12 +101,6 @@ namespace hax
     private:
     static parser *__instance;
 
-    typedef std::map<string_t, std::tuple<int, char> > optable_t;
-
-    bool is_delimiter(char);
-    void populate_optable();
-    void register_op(std::string, opcode_t, format_t);
-
     instruction_t* parse_instruction(std::string const& in_line);
 
     //~ loc_t locctr_;
@@ -110,7 +109,6 @@ namespace hax
     csect_t *csect_; // current control section
     //pblocks_t pblocks_;
 
-    optable_t optable_;
     //instructions_t instructions_;
     csects_t csects_;
     loc_t base_;
@@ -46,9 +46,12 @@ namespace hax
     public:
 
     typedef instruction inst_t;
-    typedef std::list<inst_t*> instructions_t;
 
-		program_block(string_t in_name, csect_t* in_section);
+    /**
+     * in_id is the ordinal of the block within its section, blocks are
+     * assigned addresses in the order of their ids
+     **/
+		program_block(string_t in_name, uint16_t in_id, csect_t* in_section);
 		virtual ~program_block();
 
     // program blocks can not be copied
@@ -60,22 +63,20 @@ namespace hax
      **/
     loc_t locctr() const;
     string_t const& name() const;
+    uint16_t id() const;
 
     /**
      * increments the location counter by an amount equal to the latest instruction's
-     * length,
+     * length, and records the laid out instruction in the section's store
      *
      * @param inst
      *  if an instruction is passed, its length will be used, otherwise the last
      *  instruction in this block's length will be used instead
+     *
+     * fails with hax::address_overflow when the instruction is the first one
+     * to reach past the address space
      **/
-    void step(instruction* inst=0);
-
-    /**
-     * increments the locctr by in_amount, and shifts the addresses of all registered
-     * instructions by the same amount
-     **/
-    void shift(int in_amount);
+    status_t step(instruction* inst=0);
 
     /**
      * the length of a block is equal to the lengths of all registered instructions
@@ -92,20 +93,25 @@ namespace hax
      * registers the given instruction with this program block and assigns
      * an address to it based on the location counter
      *
+     * @note
+     * the instructions of a block are shifted to the address of the block by
+     * instruction_store::relocate() once the section is assembled
+     *
      * @warning
      * the location counter is not automatically stepped, see program_block::step()
      * for more info
      **/
     void add_instruction(instruction_t* in_inst);
 
-    instructions_t const& instructions() const;
-
     protected:
 
     loc_t locctr_;
     string_t name_;
-    instructions_t instructions_;
+    uint16_t id_;
     csect_t* sect_;
+
+    /* the latest instruction registered in this block, if any */
+    instruction_t* last_;
 	};
 
   typedef program_block pblock_t;
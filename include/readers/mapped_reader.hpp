@@ -0,0 +1,57 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_mapped_reader_h
+#define h_mapped_reader_h
+
+#include "source_reader.hpp"
+
+namespace hax
+{
+  /**
+   * maps a regular file read-only into memory and hands out blocks of lines
+   * over the mapped bytes without copying them
+   *
+   * offsets are 64-bit so inputs larger than 4 GiB can be addressed, and all
+   * handed out blocks remain valid for as long as the reader is alive
+   **/
+  class mapped_reader : public source_reader {
+    public:
+
+    /**
+     * maps in_size bytes of the file open at in_fd, the reader takes ownership
+     * of the descriptor
+     *
+     * raises std::runtime_error if the file can not be mapped
+     **/
+    explicit mapped_reader(string_t const& in_path, int in_fd, offset_t in_size);
+    virtual ~mapped_reader();
+
+    virtual bool next_block(block_t& out_block);
+    virtual bool persistent() const;
+
+    protected:
+    const char* data_;
+    offset_t size_;
+    offset_t cursor_;
+    int fd_;
+  };
+} // end of namespace
+#endif // h_mapped_reader_h
@@ -0,0 +1,83 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_stream_reader_h
+#define h_stream_reader_h
+
+#include "source_reader.hpp"
+#include <vector>
+
+namespace hax
+{
+  /**
+   * streams the input from a descriptor that might not be seekable, like the
+   * standard input or a FIFO
+   *
+   * the input is read using large read(2) calls into a single buffer of
+   * source_reader::block_size bytes: the complete lines in the buffer are
+   * handed out as a block, and when the next block is requested the partial
+   * line that trails them is moved to the front of the buffer, which is then
+   * filled again. The buffer only grows past the block size if a single line
+   * does not fit in it.
+   *
+   * @note
+   * the reader is not persistent, the parser copies the entries it keeps
+   * out of every block before requesting the next one, so the memory held
+   * by the reader does not grow with the input
+   **/
+  class stream_reader : public source_reader {
+    public:
+
+    /**
+     * streams from the descriptor in_fd, which is closed when the reader is
+     * destroyed only if in_owns_fd is set
+     **/
+    explicit stream_reader(string_t const& in_path, int in_fd, bool in_owns_fd);
+    virtual ~stream_reader();
+
+    /**
+     * raises std::runtime_error if reading from the descriptor fails
+     **/
+    virtual bool next_block(block_t& out_block);
+    virtual bool persistent() const;
+
+    protected:
+
+    /**
+     * reads from the descriptor until the buffer is full or the input is
+     * exhausted
+     **/
+    void fill();
+
+    std::vector<char> buffer_;
+
+    /* the unconsumed data in the buffer lies within [begin_, end_) */
+    size_t begin_;
+    size_t end_;
+
+    /* the position of begin_ within the whole input */
+    offset_t offset_;
+
+    int fd_;
+    bool owns_fd_;
+    bool eof_;
+  };
+} // end of namespace
+#endif // h_stream_reader_h
@@ -53,29 +53,35 @@ namespace hax
     serializer(const serializer& src);
 		serializer& operator=(const serializer& rhs);
 
+    /**
+     * the part of an instruction's object code written in a T record, only
+     * the data of data-bearing instructions is ever split into several pieces
+     **/
+    struct t_piece {
+      instruction_store::handle_t instruction;
+      loc_t offset;
+      loc_t length;
+    };
+
     struct t_record {
       uint32_t length;
       uint32_t address;
-      std::vector<instruction_t*> instructions;
+      std::vector<t_piece> pieces;
 
       static const uint8_t maxlen;
     };
 
-    struct m_record {
-      uint32_t location;
-      uint32_t length;
-      //~ instruction_t* inst;
-      string_t value;
-    };
-
     /**
      * a new T record is required when:
      *  1. the current rec's length will be exceeded with the given inst
      *  2. the current rec's length is already at a maximum
      *  3. an instruction is encountered that requires a new record such as
      *     USE, RESB, RESW
+     *
+     * data longer than a whole record is instead split across as many records
+     * as it takes, see serializer::process()
      **/
-    bool requires_new_trecord(t_record* rec, instruction_t* inst);
+    bool requires_new_trecord(t_record* rec, instruction_store const& in_store, instruction_store::handle_t i);
 	};
 } // end of namespace
 #endif // h_serializer_h
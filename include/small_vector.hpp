@@ -0,0 +1,124 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_small_vector_h
+#define h_small_vector_h
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace hax
+{
+  /**
+   * a vector of trivially copyable elements that keeps up to N of them inline
+   * and only goes to the heap once it outgrows that capacity
+   *
+   * it supports what the IR needs and not much more: appending and popping,
+   * indexing, iteration and clearing
+   **/
+  template <typename T, size_t N>
+  class small_vector {
+    public:
+    static_assert(std::is_trivially_copyable<T>::value,
+      "small_vector elements are moved around as raw bytes");
+
+    typedef T* iterator;
+    typedef T const* const_iterator;
+
+    small_vector()
+    : data_(inline_data()),
+      size_(0),
+      capacity_(N)
+    {
+    }
+
+    small_vector(const small_vector& src)
+    : small_vector()
+    {
+      for (T const& value : src)
+        push_back(value);
+    }
+
+    small_vector& operator=(const small_vector& rhs)
+    {
+      if (this != &rhs)
+      {
+        clear();
+        for (T const& value : rhs)
+          push_back(value);
+      }
+
+      return *this;
+    }
+
+    ~small_vector()
+    {
+      if (data_ != inline_data())
+        delete[] reinterpret_cast<char*>(data_);
+    }
+
+    void push_back(T const& in_value)
+    {
+      if (size_ == capacity_)
+        grow();
+
+      data_[size_++] = in_value;
+    }
+
+    void pop_back() { --size_; }
+    T& back() { return data_[size_ - 1]; }
+    T const& back() const { return data_[size_ - 1]; }
+
+    void clear() { size_ = 0; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T& operator[](size_t i) { return data_[i]; }
+    T const& operator[](size_t i) const { return data_[i]; }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+
+    protected:
+    T* inline_data() { return reinterpret_cast<T*>(inline_); }
+
+    void grow()
+    {
+      T* data = reinterpret_cast<T*>(new char[sizeof(T) * capacity_ * 2]);
+      std::memcpy(static_cast<void*>(data), data_, sizeof(T) * size_);
+
+      if (data_ != inline_data())
+        delete[] reinterpret_cast<char*>(data_);
+
+      data_ = data;
+      capacity_ *= 2;
+    }
+
+    T* data_;
+    size_t size_;
+    size_t capacity_;
+    alignas(T) char inline_[sizeof(T) * N];
+  };
+} // end of namespace
+#endif // h_small_vector_h
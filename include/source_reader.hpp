@@ -0,0 +1,102 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_source_reader_h
+#define h_source_reader_h
+
+#include "hax.hpp"
+#include <cstdint>
+
+namespace hax
+{
+  /**
+   * source readers hand out the input program in blocks of whole lines, so a
+   * line is never split across two blocks
+   *
+   * persistent readers hand out blocks that remain valid for as long as the
+   * reader is alive, so instructions and operands refer to the source text
+   * instead of copying it; the blocks of other readers are only valid until
+   * the next block is requested, see source_reader::persistent()
+   *
+   * @note
+   * readers should not be created directly, see source_reader::open()
+   **/
+  class source_reader {
+    public:
+    typedef uint64_t offset_t;
+
+    struct block_t {
+      /* the first character of the block */
+      const char* data;
+
+      /* the number of characters in the block, newlines included */
+      size_t length;
+
+      /* the position of the block within the whole input */
+      offset_t offset;
+    };
+
+    /* the amount of bytes a reader aims to hand out per block */
+    static const size_t block_size;
+
+    /**
+     * creates the reader suited to the input found at in_path:
+     *
+     *  1. "-" denotes the standard input, which is streamed
+     *  2. regular files are mapped into memory
+     *  3. anything else, like FIFOs and character devices, is streamed
+     *
+     * raises std::runtime_error if the input can not be opened
+     *
+     * @warning
+     * the caller owns the returned reader
+     **/
+    static source_reader* open(string_t const& in_path);
+
+    virtual ~source_reader();
+
+    source_reader()=delete;
+    source_reader(const source_reader& src)=delete;
+    source_reader& operator=(const source_reader& rhs)=delete;
+
+    /**
+     * assigns the next block of lines to out_block, returns false once the
+     * whole input has been consumed
+     *
+     * the last line of the input is handed out even if it is not terminated
+     * by a newline
+     **/
+    virtual bool next_block(block_t& out_block)=0;
+
+    /**
+     * whether handed out blocks remain valid for as long as the reader is
+     * alive, rather than only until the next call to next_block()
+     **/
+    virtual bool persistent() const=0;
+
+    string_t const& path() const;
+
+    protected:
+    explicit source_reader(string_t const& in_path);
+
+    string_t path_;
+  };
+} // end of namespace
+#endif // h_source_reader_h
@@ -0,0 +1,103 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_string_interner_h
+#define h_string_interner_h
+
+#include "hax.hpp"
+#include "arena.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace hax
+{
+  /**
+   * hands out dense 32-bit ids for the names used in a control section, the
+   * same name always maps to the same id and ids are assigned in the order
+   * names are first seen
+   *
+   * names are kept in an open-addressing table with linear probing: every
+   * slot carries the precomputed hash of its name, and names short enough
+   * to fit (which covers all SIC/XE labels) are stored inline in the slot so
+   * a lookup does not leave the table
+   *
+   * the characters of every interned name are copied into the given arena
+   * and remain valid for as long as the arena is alive
+   **/
+  class string_interner {
+    public:
+    typedef uint32_t id_t;
+
+    /* returned by find() for names that were never interned */
+    static const id_t nil;
+
+    explicit string_interner(arena_t& in_arena);
+    virtual ~string_interner();
+
+    string_interner(const string_interner& src)=delete;
+    string_interner& operator=(const string_interner& rhs)=delete;
+
+    /**
+     * returns the id of in_name, interning it first if it is new
+     **/
+    id_t intern(std::string_view in_name);
+
+    /**
+     * returns the id of in_name, or string_interner::nil if it was never interned
+     **/
+    id_t find(std::string_view in_name) const;
+
+    /**
+     * the name identified by in_id
+     **/
+    std::string_view name(id_t in_id) const;
+
+    /* the number of interned names */
+    size_t size() const;
+
+    protected:
+    /* the longest name that is stored inline in a slot */
+    static const size_t inline_length = 7;
+
+    struct slot_t {
+      uint32_t hash;
+      id_t id;
+      uint8_t length;
+      char key[inline_length];
+    };
+
+    static_assert(sizeof(slot_t) == 16, "four interner slots are expected to share a cache line");
+
+    static uint32_t hash(std::string_view in_name);
+
+    /* the slot holding in_name, or the empty slot it would be placed in */
+    size_t probe(std::string_view in_name, uint32_t in_hash) const;
+
+    /* doubles the table and re-places every slot by its stored hash */
+    void grow();
+
+    arena_t& arena_;
+    std::vector<slot_t> slots_;
+    std::vector<std::string_view> names_;
+    size_t mask_;
+  };
+} // end of namespace
+#endif // h_string_interner_h
@@ -25,14 +25,31 @@
 #include "instruction.hpp"
 #include "instructions/literal.hpp"
 #include "operands/symbol.hpp"
+#include "string_interner.hpp"
 #include <map>
+#include <string_view>
 
 namespace hax
 {
   class control_section;
+  class directive;
+
+  /**
+   * the symbol table of a control section
+   *
+   * symbol names are interned in the section and the id of a name is the id
+   * of the symbol declared by it, symbols are kept in a table indexed by that
+   * id so every lookup is a single probe of the interner
+   *
+   * the built-in symbols (the registers, "0" and "*") are not part of any
+   * section, they live in one immutable table shared by the whole process
+   * that is consulted before the section's own symbols
+   **/
   class symbol_manager {
     public:
-    typedef std::map<string_t, symbol_t*> symbols_t;
+
+    /* indexed by symbol id, undefined entries are 0 */
+    typedef std::vector<symbol_t*> symbols_t;
 
 		symbol_manager(control_section* in_sect);
 		virtual ~symbol_manager();
@@ -47,7 +64,7 @@ namespace hax
      * Declared symbols have a value and address of 0x0, and are known to be
      * "non-defined", to check for a symbol's definition, call operand::is_evaluated()
      **/
-    symbol_t* const declare(string_t const& in_name);
+    symbol_t* const declare(std::string_view in_name);
 
     /**
      * Assigns the address in_loc to the given symbol in_symbol.
@@ -63,23 +80,89 @@ namespace hax
     /**
      * Returns the symbol identified by name in_name, or 0 in case it wasn't found.
      **/
-    symbol_t* const lookup(string_t const& in_name) const;
+    symbol_t* const lookup(std::string_view in_name) const;
+
+    /**
+     * Returns the symbol identified by in_id, or 0 in case it was undefined.
+     **/
+    symbol_t* const lookup(symbol_id_t in_id) const;
+
+    /**
+     * Returns the name identified by in_id, which remains known even if the
+     * symbol was undefined.
+     **/
+    std::string_view name(symbol_id_t in_id) const;
+
+    /**
+     * Returns the built-in symbol named in_name, or 0 if there is none.
+     *
+     * @note
+     * built-in symbols are shared by all sections and must not be modified
+     **/
+    static symbol_t* const builtin(std::string_view in_name);
+
+    /**
+     * Built-in symbols are identified by ids at or above this one, which are
+     * never handed out to the symbols of a section.
+     **/
+    static const symbol_id_t builtin_base;
+
+    static bool is_builtin(symbol_id_t in_id);
 
     /**
      * Convenience method for checking whether a symbol has been declared.
      **/
-    bool is_declared(string_t const& in_name) const;
+    bool is_declared(std::string_view in_name) const;
 
     /**
      * Convenience method for checking whether a symbol has been both declared
      * and evaluated.
      **/
-    bool is_defined(string_t const& in_name) const;
+    bool is_defined(std::string_view in_name) const;
 
 
+    /**
+     * all symbols declared in this section, indexed by their id, the
+     * built-in symbols are not included
+     *
+     * @note
+     * the table is ordered by declaration and can contain null entries for
+     * symbols that were undefined
+     **/
     symbols_t const& symbols() const;
 
-    void __undefine(string_t const& in_sym);
+    /**
+     * the declared symbols sorted by their names
+     **/
+    std::vector<symbol_t*> sorted_symbols() const;
+
+    void __undefine(std::string_view in_sym);
+
+    /**
+     * the values of symbols only ever change all at once, when the program
+     * blocks of the section are relocated; the epoch counts those changes so
+     * whatever is computed from symbol values can be memoized within one
+     **/
+    uint32_t epoch() const;
+    void __advance_epoch();
+
+    /**
+     * defers the definition of the symbol labelling the EQU directive in_equ,
+     * whose operand refers to symbols that are not defined yet, until
+     * resolve_definitions() is called
+     **/
+    void defer_definition(directive* in_equ);
+
+    /**
+     * defines the symbols of the deferred EQU directives once all entries have
+     * been read, every definition after the ones it depends on
+     *
+     * the definitions and the symbols they refer to form a graph that is
+     * walked depth-first once, so this is linear in the number of references;
+     * cycles and references to symbols that are never defined are tracked as
+     * errors, and the definitions depending on them are left undefined
+     **/
+    void resolve_definitions();
 
     /**
      * Declares a literal with in_value, and adds the given operand as a dependant
@@ -92,7 +175,7 @@ namespace hax
      * @param in_value
      *  fully-qualified literal format, ie: =X'F1' or =C'FOOBAR'
      **/
-    instruction* declare_literal(string_t const& in_value, operand* in_dependency);
+    instruction* declare_literal(std::string_view in_value, operand* in_dependency);
 
     /**
      * Returns a literal identified by the given value.
@@ -102,7 +185,7 @@ namespace hax
      * the literal was not found, which should really not happen and if it does
      * it indicates a bug
      **/
-    instruction* lookup_literal(string_t const& in_value);
+    instruction* lookup_literal(std::string_view in_value);
 
     /**
      * Extracts all literals registered in the pool to the current location
@@ -112,8 +195,10 @@ namespace hax
      * When do_step is set to true, the program_block of this section will
      * step its location counter when the literal table is dumped. This is required
      * when no LTORG is specified, and the pool is dumped at the end of the file.
+     *
+     * Fails on the first literal that can not be assembled.
      **/
-    void dump_literal_pool(bool do_step = false);
+    status_t dump_literal_pool(bool do_step = false);
 
     /**
      * Convenience method for writing the symbol table to out.
@@ -121,11 +206,22 @@ namespace hax
     void dump(std::ostream& out) const;
 
     protected:
-    typedef std::map<string_t, literal*> literals_t;
+    typedef std::vector<symbol_t> builtins_t;
+
+    /* the shared table of built-in symbols, created on first use */
+    static builtins_t const& builtins();
+
+    /* keyed by the literal as it appears in the source text */
+    typedef std::map<std::string_view, literal*> literals_t;
     literals_t literals_;
 
-    symbols_t symbols_;
     control_section *sect_;
+    string_interner names_;
+    symbols_t symbols_;
+    uint32_t epoch_;
+
+    /* EQU directives waiting for resolve_definitions() */
+    std::vector<directive*> deferred_;
 
     private:
     //~ static symbol_manager *__instance;
@@ -0,0 +1,123 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef h_tokenizer_h
+#define h_tokenizer_h
+
+#include "hax.hpp"
+#include "line_scanner.hpp"
+#include "optable.hpp"
+#include "hax_status.hpp"
+#include "arena.hpp"
+#include <string_view>
+#include <cstdint>
+
+namespace hax
+{
+  /**
+   * an entry is a single source line broken into its fields, every field is a
+   * span into the source buffer so no characters are copied while tokenizing
+   *
+   * fields are stored in the slot of the role they play in the entry, a field
+   * that is not present in the entry is an empty span
+   **/
+  struct entry_t {
+    enum role_t : uint8_t {
+      r_label = 0,
+      r_mnemonic,
+      r_operand,
+      max_fields
+    };
+
+    enum flag_t : uint8_t {
+      f_extended  = 0x01, // mnemonic prefixed by '+'
+      f_immediate = 0x02, // operand prefixed by '#'
+      f_indirect  = 0x04, // operand prefixed by '@'
+      f_indexed   = 0x08  // operand suffixed by ',X'
+    };
+
+    /* the trimmed line with any comments stripped out */
+    std::string_view line;
+
+    std::string_view fields[max_fields];
+
+    /* combination of entry_t::flag_t */
+    uint8_t flags;
+
+    /* the optable entry of the mnemonic, or 0 if it is missing or unrecognized */
+    const op_t* op;
+
+    bool has(role_t in_role) const { return !fields[in_role].empty(); }
+
+    std::string_view label() const { return fields[r_label]; }
+
+    /**
+     * the mnemonic as it appears in the source, including the '+' prefix of
+     * extended format operations
+     **/
+    std::string_view mnemonic() const { return fields[r_mnemonic]; }
+
+    /**
+     * the operand field as it appears in the source, including any addressing
+     * mode prefix and the ',X' index suffix
+     **/
+    std::string_view operand() const { return fields[r_operand]; }
+  };
+
+  /**
+   * turns the lines found by the line_scanner into entries
+   **/
+  class tokenizer {
+    public:
+
+    /**
+     * assigns the fields of in_line, which was scanned from the block starting
+     * at in_block, to their roles in out_entry
+     *
+     * the first field is taken to be a label unless it is a registered operation,
+     * and an invalid_entry status is returned if there are more fields than an
+     * entry can hold
+     *
+     * the mnemonic is looked up in the optable only once, here, and the entry
+     * is given what was found
+     **/
+    static status_t tokenize(const char* in_block, scanned_line_t const& in_line, entry_t& out_entry);
+
+    /**
+     * computes the entry_t::flag_t bits denoted by the prefix and suffix of
+     * the given operand field
+     **/
+    static uint8_t operand_flags(std::string_view in_operand);
+
+    /**
+     * copies the line of io_entry into in_arena and points the line and the
+     * fields of io_entry at the copy, for entries read from a block that is
+     * recycled before the instructions made from them are done with
+     **/
+    static void copy_into(arena_t& in_arena, entry_t& io_entry);
+
+    private:
+    /* looks up a mnemonic field, which may carry the '+' prefix, in the optable */
+    static const op_t* lookup(std::string_view in_mnemonic);
+
+    tokenizer()=delete;
+  };
+} // end of namespace
+#endif // h_tokenizer_h
@@ -0,0 +1,112 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "arena.hpp"
+#include "hax_stats.hpp"
+#include <cstdlib>
+
+namespace hax
+{
+  const size_t arena::chunk_size = 64 * 1024;
+
+  arena::arena()
+  : cursor_(0),
+    limit_(0),
+    chunks_(0),
+    destructors_(0),
+    nr_allocations_(0),
+    nr_chunks_(0)
+  {
+  }
+
+  arena::~arena()
+  {
+    // the destructor records themselves live in the chunks, so they must all
+    // be visited before any chunk is released
+    for (destructor_t* d = destructors_; d; d = d->next)
+      d->destroy(d->object);
+
+    while (chunks_)
+    {
+      chunk_t* next = chunks_->next;
+      std::free(chunks_);
+      chunks_ = next;
+    }
+
+    cursor_ = limit_ = 0;
+    destructors_ = 0;
+  }
+
+  void* arena::allocate(size_t in_size, size_t in_align)
+  {
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor_) + in_align - 1) & ~(uintptr_t(in_align) - 1);
+    if (!cursor_ || aligned + in_size > reinterpret_cast<uintptr_t>(limit_))
+    {
+      grow(in_size + in_align);
+      aligned = (reinterpret_cast<uintptr_t>(cursor_) + in_align - 1) & ~(uintptr_t(in_align) - 1);
+    }
+
+    cursor_ = reinterpret_cast<char*>(aligned + in_size);
+
+    ++nr_allocations_;
+    ++stats::arena_allocations;
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  void arena::track_destructor(void* in_object, void (*in_destroy)(void*))
+  {
+    destructor_t* d = new (allocate(sizeof(destructor_t), alignof(destructor_t))) destructor_t();
+    d->destroy = in_destroy;
+    d->object = in_object;
+    d->next = destructors_;
+    destructors_ = d;
+
+    // bookkeeping is not an allocation the caller asked for
+    --nr_allocations_;
+    --stats::arena_allocations;
+  }
+
+  void arena::grow(size_t in_size)
+  {
+    size_t size = sizeof(chunk_t) + (in_size > chunk_size ? in_size : chunk_size);
+    chunk_t* chunk = static_cast<chunk_t*>(std::malloc(size));
+    if (!chunk)
+      throw std::bad_alloc();
+
+    chunk->next = chunks_;
+    chunks_ = chunk;
+
+    cursor_ = reinterpret_cast<char*>(chunk + 1);
+    limit_ = reinterpret_cast<char*>(chunk) + size;
+
+    ++nr_chunks_;
+    ++stats::arena_chunks;
+  }
+
+  size_t arena::nr_allocations() const
+  {
+    return nr_allocations_;
+  }
+
+  size_t arena::nr_chunks() const
+  {
+    return nr_chunks_;
+  }
+} // end of namespace
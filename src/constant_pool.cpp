@@ -0,0 +1,96 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "constant_pool.hpp"
+#include "control_section.hpp"
+#include "hax_stats.hpp"
+
+namespace hax
+{
+  constant_pool::constant_pool(control_section* in_sect)
+  : sect_(in_sect),
+    keys_(in_sect->arena())
+  {
+  }
+
+  constant_pool::~constant_pool()
+  {
+    // the constants are released by the arena of the section
+    constants_.clear();
+    sect_ = 0;
+  }
+
+  bool constant_pool::is_poolable(operand_class_t const& in_class)
+  {
+    switch (in_class.kind)
+    {
+      case operand_class_t::k_decimal:
+      case operand_class_t::k_hex_constant:
+      case operand_class_t::k_ascii_constant:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  status_t constant_pool::acquire(std::string_view in_token, operand_class_t const& in_class, string_t const& in_line,
+                                  constant_t*& out_constant)
+  {
+    assert(is_poolable(in_class));
+
+    // the addressing mode prefix belongs to the instruction, not the constant
+    operand_class_t key_class = in_class;
+    key_class.prefix = 0;
+    key_class.payload_begin -= in_class.prefix;
+    key_class.payload_end -= in_class.prefix;
+
+    std::string_view key = in_token.substr(in_class.prefix);
+    string_interner::id_t id = keys_.find(key);
+    if (id != string_interner::nil)
+    {
+      ++stats::shared_constants;
+      stats::shared_constant_bytes += sizeof(constant_t);
+      out_constant = constants_[id];
+      return status_t();
+    }
+
+    // the key is interned only once the constant has been evaluated, so one
+    // that fails to is not left half-registered
+    constant_t* constant = sect_->arena().create<constant_t>(key, static_cast<instruction*>(0), key_class);
+    status_t result = constant->__share();
+
+    // shared constants are not tied to any one line, point at this one
+    if (!result.ok())
+      return status_t::failure(invalid_operand(result.error().what(), in_line));
+
+    id = keys_.intern(key);
+    assert(id == constants_.size());
+    constants_.push_back(constant);
+
+    ++stats::pooled_constants;
+    out_constant = constant;
+    return result;
+  }
+
+  size_t constant_pool::size() const
+  {
+    return constants_.size();
+  }
+} // end of namespace
@@ -21,13 +21,18 @@
 #include "control_section.hpp"
 #include "serializer.hpp"
 #include "parser.hpp"
+#include "fmt3_instruction.hpp"
+#include "encoders.hpp"
 
 namespace hax
 {
   control_section::control_section(string_t in_name)
   : name_(in_name),
-    pblock_(new program_block("Unnamed", this)),
+    arena_(),
+    pblock_(new program_block("Unnamed", 0, this)),
     symmgr_(new symbol_manager(this)),
+    constants_(this),
+    expressions_(this),
     starting_addr_(0x0),
     starting_addr_set_(false)
   {
@@ -42,12 +47,6 @@ namespace hax
       pblocks_.pop_back();
     }
 
-    while (!instructions_.empty())
-    {
-      delete instructions_.back();
-      instructions_.pop_back();
-    }
-
     delete symmgr_;
     symmgr_ = 0;
     pblock_ = 0;
@@ -76,6 +75,24 @@ namespace hax
     return symmgr_;
   }
 
+  arena_t&
+  control_section::arena()
+  {
+    return arena_;
+  }
+
+  constant_pool&
+  control_section::constants()
+  {
+    return constants_;
+  }
+
+  expression_pool&
+  control_section::expressions()
+  {
+    return expressions_;
+  }
+
   pblock_t*
   control_section::block() const
   {
@@ -99,7 +116,7 @@ namespace hax
       }
 
 
-    pblock_ = new program_block(in_name, this);
+    pblock_ = new program_block(in_name, pblocks_.size(), this);
     pblocks_.push_back(pblock_);
     std::cout << "switching to new program block: " << pblock_->name() << "\n";
   }
@@ -107,10 +124,16 @@ namespace hax
   void
   control_section::__add_instruction(instruction_t* in_inst)
   {
-    instructions_.push_back(in_inst);
+    instructions_.add(in_inst, in_inst->block()->id());
   }
 
-  const control_section::instructions_t&
+  instruction_store&
+  control_section::instructions()
+  {
+    return instructions_;
+  }
+
+  instruction_store const&
   control_section::instructions() const
   {
     return instructions_;
@@ -121,40 +144,55 @@ namespace hax
   {
     //~ symmgr_->dump_literal_pool(true);
 
-    int idx = 0;
+    std::vector<loc_t> offsets;
+    offsets.reserve(pblocks_.size());
+
+    loc_t idx = 0;
     for (auto block : pblocks_) {
       std::cout << "Assigning address to program block '" << block->name() << "' = " << idx << "\n";
-      block->shift(idx);
+      offsets.push_back(idx);
       idx += block->length();
     }
 
-    bool failed = false;
-    for (auto inst : instructions_)
+    // every block fits on its own, but together they might not
+    if (idx > address_space)
     {
-      try {
-        inst->assemble();
-      } catch (hax_error& e) {
-        parser::singleton().track_error(e);
-      }
-      //~ std::cout << inst << "\n";
-    }
+      std::ostringstream msg;
+      msg << "the program blocks of control section '" << name_ << "' take 0x"
+        << std::hex << std::uppercase << idx << " bytes, past the 20-bit address space";
 
-    if (failed) {
-      return parser::singleton().report_errors();
+      address_overflow e(msg.str(), name_);
+      parser::singleton().track_error(e);
+      return;
     }
 
-    for (auto inst : instructions_)
+    instructions_.relocate(offsets);
+    symmgr_->__advance_epoch();
+
+    // format 3 instructions are only gathered here and encoded together in
+    // one batch below, everything else is assembled in order since BASE
+    // directives change the base register the gathered ones are encoded against
+    encoding::fmt3_batch batch;
+    const size_t count = instructions_.size();
+    for (size_t i = 0; i < count; ++i)
     {
-      try {
-        inst->postprocess();
-      } catch (hax_error& e) {
-        parser::singleton().track_error(e);
-        failed = true;
-      }
+      instruction_t* inst = instructions_.instruction_at(i);
+      if (instructions_.format(i) == format::fmt_three)
+        parser::singleton().track_error(static_cast<fmt3_instruction*>(inst)->gather(batch));
+      else
+        parser::singleton().track_error(inst->assemble());
+      //~ std::cout << inst << "\n";
     }
 
-    if (failed) {
-      parser::singleton().report_errors();
+    batch.encode();
+    for (size_t i = 0; i < batch.size(); ++i)
+      parser::singleton().track_error(batch.instruction_at(i)->assign_objcode(batch.objcode_at(i), batch.target_at(i)));
+
+    // the errors are reported by the parser once every section is assembled
+    for (size_t i = 0; i < count; ++i)
+    {
+      parser::singleton().track_error(instructions_.instruction_at(i)->postprocess());
+      instructions_.record_pass2(i);
     }
   }
 
@@ -0,0 +1,264 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "encoders.hpp"
+#include <cassert>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+# define HAX_ENCODER_X86 1
+# include <emmintrin.h>
+#endif
+
+namespace hax
+{
+namespace encoding {
+
+  namespace {
+    // encodings taken from the object programs of Beck's figures 2.6, 2.12 and 2.16
+
+    // CLEAR X
+    static_assert(fmt2::encode(0xB4, 1, 0) == 0xB410, "");
+    // COMPR A,S
+    static_assert(fmt2::encode(0xA0, 0, 4) == 0xA004, "");
+    // TIXR T
+    static_assert(fmt2::encode(0xB8, 5, 0) == 0xB850, "");
+
+    // STL RETADR: PC-relative
+    static_assert(fmt3<instruction::simple, false>::relative(0x14, 0x0030, 0x0003, 0) == 0x17202D, "");
+    // LDB #LENGTH: immediate, PC-relative
+    static_assert(fmt3<instruction::immediate, false>::relative(0x68, 0x0033, 0x0006, 0) == 0x69202D, "");
+    // J CLOOP: PC-relative, backwards
+    static_assert(fmt3<instruction::simple, false>::relative(0x3C, 0x0006, 0x001A, 0) == 0x3F2FEC, "");
+    // J @RETADR: indirect, PC-relative
+    static_assert(fmt3<instruction::indirect, false>::relative(0x3C, 0x0030, 0x002D, 0) == 0x3E2003, "");
+    // LDA #3: immediate constant
+    static_assert(fmt3<instruction::immediate, false>::absolute(0x00, 3, 0x0023, 0) == 0x010003, "");
+    // RSUB
+    static_assert(fmt3<instruction::simple, false>::absolute(0x4C, 0, 0x105D, 0) == 0x4F0000, "");
+    // STCH BUFFER,X: indexed, base-relative
+    static_assert(fmt3<instruction::simple, true>::relative(0x54, 0x0036, 0x1054, 0x0033) == 0x57C003, "");
+    // LDCH BUFFER,X: indexed, PC-relative (blocks)
+    static_assert(fmt3<instruction::simple, true>::relative(0x50, 0x0071, 0x005B, 0) == 0x53A016, "");
+    // LDT LENGTH: PC-relative (blocks)
+    static_assert(fmt3<instruction::simple, false>::relative(0x74, 0x0069, 0x0052, 0) == 0x772017, "");
+    // a target beyond every displacement
+    static_assert(fmt3<instruction::simple, false>::relative(0x00, 0x2000, 0x0003, 0) == out_of_bounds, "");
+
+    // +JSUB RDREC
+    static_assert(fmt4<instruction::simple, false>::encode(0x48, 0x1036, 0x000A, 0) == 0x4B101036, "");
+    // +LDT #4096
+    static_assert(fmt4<instruction::immediate, false>::encode(0x74, 4096, 0x1051, 0) == 0x75101000, "");
+    // +LDCH BUFFER,X: external reference
+    static_assert(fmt4<instruction::simple, true>::encode(0x50, 0, 0x0011, 0) == 0x53900000, "");
+    // +LDA EXT-3: completed by a modification record
+    static_assert(fmt4<instruction::simple, false>::encode(0x00, -3, 0x0004, 0) == 0x031FFFFD, "");
+    // +LDA #2000000: wider than the address field
+    static_assert(fmt4<instruction::immediate, false>::encode(0x00, 2000000, 0x0004, 0) == out_of_bounds, "");
+
+    // indexed by [mode][indexed][constant], the mode being the n and i bits
+    constexpr encoder_t fmt3_encoders[4][2][2] = {
+      { { 0, 0 }, { 0, 0 } },
+      {
+        { &fmt3<instruction::immediate, false>::relative, &fmt3<instruction::immediate, false>::absolute },
+        { &fmt3<instruction::immediate, true>::relative,  &fmt3<instruction::immediate, true>::absolute }
+      },
+      {
+        { &fmt3<instruction::indirect, false>::relative,  &fmt3<instruction::indirect, false>::absolute },
+        { &fmt3<instruction::indirect, true>::relative,   &fmt3<instruction::indirect, true>::absolute }
+      },
+      {
+        { &fmt3<instruction::simple, false>::relative,    &fmt3<instruction::simple, false>::absolute },
+        { &fmt3<instruction::simple, true>::relative,     &fmt3<instruction::simple, true>::absolute }
+      }
+    };
+
+    constexpr encoder_t fmt4_encoders[4][2] = {
+      { 0, 0 },
+      { &fmt4<instruction::immediate, false>::encode, &fmt4<instruction::immediate, true>::encode },
+      { 0, 0 },
+      { &fmt4<instruction::simple, false>::encode,    &fmt4<instruction::simple, true>::encode }
+    };
+
+    inline size_t ni_bits(uint32_t in_mode)
+    {
+      return (in_mode >> 16) & 0x3;
+    }
+  }
+
+  encoder_t select_fmt3(uint32_t in_mode, bool in_indexed, bool in_constant)
+  {
+    return fmt3_encoders[ni_bits(in_mode)][in_indexed][in_constant];
+  }
+
+  encoder_t select_fmt4(uint32_t in_mode, bool in_indexed)
+  {
+    return fmt4_encoders[ni_bits(in_mode)][in_indexed];
+  }
+
+  void fmt3_batch::add(fmt3_instruction* in_inst, opcode_t in_opcode, uint32_t in_mode, bool in_indexed,
+                       bool in_absolute, int in_target, int in_pc, int in_base)
+  {
+    insts_.push_back(in_inst);
+    heads_.push_back(head(in_opcode, in_mode, in_indexed));
+    absolute_.push_back(in_absolute ? 0xFFFFFFFF : 0);
+    targets_.push_back(in_target);
+    pcs_.push_back(in_pc);
+    bases_.push_back(in_base);
+  }
+
+  objcode_t fmt3_batch::head(opcode_t in_opcode, uint32_t in_mode, bool in_indexed)
+  {
+    return (objcode_t(in_opcode) << 16) | in_mode | (in_indexed ? fmt3_x : 0);
+  }
+
+  void fmt3_batch::encode()
+  {
+    objcodes_.resize(insts_.size());
+    if (objcodes_.empty())
+      return;
+
+#ifdef HAX_ENCODER_X86
+    encode_sse2(&heads_[0], &absolute_[0], &targets_[0], &pcs_[0], &bases_[0], &objcodes_[0], objcodes_.size());
+#else
+    encode_scalar(&heads_[0], &absolute_[0], &targets_[0], &pcs_[0], &bases_[0], &objcodes_[0], objcodes_.size());
+#endif
+
+#ifndef NDEBUG
+    // the batch must agree with the reference encoders
+    for (size_t i = 0; i < objcodes_.size(); ++i)
+    {
+      uint32_t mode = heads_[i] & 0x030000;
+      bool indexed = heads_[i] & fmt3_x;
+      opcode_t opcode = (heads_[i] >> 16) & 0xFC;
+      encoder_t encoder = select_fmt3(mode, indexed, absolute_[i]);
+      assert(encoder(opcode, targets_[i], pcs_[i], bases_[i]) == objcodes_[i]);
+    }
+#endif
+  }
+
+  void fmt3_batch::encode_scalar(const objcode_t* in_heads, const uint32_t* in_absolute,
+                                 const int32_t* in_targets, const int32_t* in_pcs,
+                                 const int32_t* in_bases, objcode_t* out_objcodes, size_t in_count)
+  {
+    for (size_t i = 0; i < in_count; ++i)
+    {
+      uint32_t target = uint32_t(in_targets[i]);
+      uint32_t pc_disp = target - uint32_t(in_pcs[i]);
+      uint32_t base_disp = target - uint32_t(in_bases[i]);
+
+      // each mask is all ones when its targeting mode is usable, and only the
+      // first usable mode in the order PC, base, direct is kept
+      uint32_t relative = ~in_absolute[i];
+      uint32_t pc_ok = relative & (0 - uint32_t(((pc_disp + 2048) & ~0xFFFu) == 0));
+      uint32_t base_ok = relative & ~pc_ok & (0 - uint32_t((base_disp & ~0xFFFu) == 0));
+      uint32_t direct_ok = ~pc_ok & ~base_ok & (0 - uint32_t((target & ~0xFFFu) == 0));
+
+      out_objcodes[i] =
+          (pc_ok & (in_heads[i] | fmt3_p | (pc_disp & 0xFFF)))
+        | (base_ok & (in_heads[i] | fmt3_b | base_disp))
+        | (direct_ok & (in_heads[i] | target))
+        | ~(pc_ok | base_ok | direct_ok);
+    }
+  }
+
+  void fmt3_batch::encode_sse2(const objcode_t* in_heads, const uint32_t* in_absolute,
+                               const int32_t* in_targets, const int32_t* in_pcs,
+                               const int32_t* in_bases, objcode_t* out_objcodes, size_t in_count)
+  {
+#ifdef HAX_ENCODER_X86
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i high_bits = _mm_set1_epi32(~0xFFF);
+    const __m128i low_bits = _mm_set1_epi32(0xFFF);
+    const __m128i half_range = _mm_set1_epi32(2048);
+    const __m128i p_bit = _mm_set1_epi32(fmt3_p);
+    const __m128i b_bit = _mm_set1_epi32(fmt3_b);
+
+    size_t i = 0;
+    for (; i + 4 <= in_count; i += 4)
+    {
+      __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in_heads + i));
+      __m128i absolute = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in_absolute + i));
+      __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in_targets + i));
+      __m128i pc = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in_pcs + i));
+      __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in_bases + i));
+
+      __m128i pc_disp = _mm_sub_epi32(target, pc);
+      __m128i base_disp = _mm_sub_epi32(target, base);
+
+      __m128i pc_ok = _mm_andnot_si128(absolute,
+        _mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(pc_disp, half_range), high_bits), zero));
+      __m128i base_ok = _mm_andnot_si128(_mm_or_si128(absolute, pc_ok),
+        _mm_cmpeq_epi32(_mm_and_si128(base_disp, high_bits), zero));
+      __m128i direct_ok = _mm_andnot_si128(_mm_or_si128(pc_ok, base_ok),
+        _mm_cmpeq_epi32(_mm_and_si128(target, high_bits), zero));
+
+      __m128i objcode = _mm_or_si128(
+        _mm_and_si128(pc_ok, _mm_or_si128(_mm_or_si128(head, p_bit), _mm_and_si128(pc_disp, low_bits))),
+        _mm_or_si128(
+          _mm_and_si128(base_ok, _mm_or_si128(_mm_or_si128(head, b_bit), base_disp)),
+          _mm_and_si128(direct_ok, _mm_or_si128(head, target))));
+
+      // lanes that can not be reached by any mode are set to out_of_bounds
+      __m128i unreachable = _mm_xor_si128(_mm_or_si128(pc_ok, _mm_or_si128(base_ok, direct_ok)), ones);
+      objcode = _mm_or_si128(objcode, unreachable);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out_objcodes + i), objcode);
+    }
+
+    encode_scalar(in_heads + i, in_absolute + i, in_targets + i, in_pcs + i, in_bases + i,
+                  out_objcodes + i, in_count - i);
+#else
+    encode_scalar(in_heads, in_absolute, in_targets, in_pcs, in_bases, out_objcodes, in_count);
+#endif
+  }
+
+  size_t fmt3_batch::size() const
+  {
+    return insts_.size();
+  }
+
+  void fmt3_batch::clear()
+  {
+    insts_.clear();
+    heads_.clear();
+    absolute_.clear();
+    targets_.clear();
+    pcs_.clear();
+    bases_.clear();
+    objcodes_.clear();
+  }
+
+  fmt3_instruction* fmt3_batch::instruction_at(size_t in_idx) const
+  {
+    return insts_[in_idx];
+  }
+
+  objcode_t fmt3_batch::objcode_at(size_t in_idx) const
+  {
+    return objcodes_[in_idx];
+  }
+
+  int fmt3_batch::target_at(size_t in_idx) const
+  {
+    return targets_[in_idx];
+  }
+} // end of namespace encoding
+} // end of namespace
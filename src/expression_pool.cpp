@@ -0,0 +1,77 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "expression_pool.hpp"
+#include "control_section.hpp"
+#include "hax_stats.hpp"
+
+namespace hax
+{
+  expression_pool::expression_pool(control_section* in_sect)
+  : sect_(in_sect),
+    keys_(in_sect->arena())
+  {
+  }
+
+  expression_pool::~expression_pool()
+  {
+    // the expressions are released by the arena of the section
+    expressions_.clear();
+    sect_ = 0;
+  }
+
+  status_t expression_pool::acquire(std::string_view in_token, operand_class_t const& in_class, instruction* in_inst,
+                                    expression_t*& out_expr)
+  {
+    assert(in_class.kind == operand_class_t::k_expression);
+
+    // the addressing mode prefix belongs to the instruction, not the expression
+    std::string_view key = in_token.substr(in_class.prefix);
+    string_interner::id_t id = keys_.find(key);
+    if (id != string_interner::nil)
+    {
+      ++stats::shared_expressions;
+      out_expr = expressions_[id];
+      return status_t();
+    }
+
+    // the key is interned only once the expression has been compiled, so one
+    // that fails to is not left half-registered
+    expression_t* expr = sect_->arena().create<expression_t>(key, in_inst);
+    status_t result = expr->compile();
+    if (!result.ok())
+      return result;
+
+    expr->__share();
+
+    id = keys_.intern(key);
+    assert(id == expressions_.size());
+    expressions_.push_back(expr);
+
+    ++stats::pooled_expressions;
+    out_expr = expr;
+    return result;
+  }
+
+  size_t expression_pool::size() const
+  {
+    return expressions_.size();
+  }
+} // end of namespace
@@ -0,0 +1,116 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hax_stats.hpp"
+#include <cstdlib>
+#include <new>
+#include <sys/resource.h>
+
+namespace hax
+{
+namespace stats {
+
+  uint64_t lines = 0;
+  uint64_t heap_allocations = 0;
+  uint64_t pass1_heap_allocations = 0;
+  uint64_t arena_allocations = 0;
+  uint64_t arena_chunks = 0;
+  uint64_t pooled_constants = 0;
+  uint64_t shared_constants = 0;
+  uint64_t shared_constant_bytes = 0;
+  uint64_t pooled_expressions = 0;
+  uint64_t shared_expressions = 0;
+  uint64_t folded_operations = 0;
+  uint64_t saved_evaluations = 0;
+
+  void dump(std::ostream& out)
+  {
+    out
+      << std::dec
+      << "+- Statistics:\n"
+      << "+-\tEntries: " << lines << "\n";
+
+#ifdef HAX_COUNT_ALLOCATIONS
+    out
+      << "+-\tHeap allocations: " << heap_allocations << "\n"
+      << "+-\tHeap allocations in pass 1: " << pass1_heap_allocations;
+
+    if (lines)
+      out << " (" << double(pass1_heap_allocations) / lines << " per entry)";
+
+    out << "\n";
+#else
+    out << "+-\tHeap allocations: not counted, configure with -DHASM_COUNT_ALLOCATIONS=ON\n";
+#endif
+
+    out
+      << "+-\tArena allocations: " << arena_allocations
+      << " in " << arena_chunks << " chunks\n"
+      << "+-\tConstant operands: " << pooled_constants << " created, "
+      << shared_constants << " shared (" << shared_constant_bytes << " bytes saved)\n"
+      << "+-\tExpression operands: " << pooled_expressions << " compiled, "
+      << shared_expressions << " shared, " << folded_operations << " operations folded, "
+      << saved_evaluations << " evaluations saved\n";
+
+    // reported in kilobytes on linux
+    rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) == 0)
+      out << "+-\tPeak resident set size: " << usage.ru_maxrss << " KB\n";
+  }
+} // end of namespace stats
+} // end of namespace
+
+#ifdef HAX_COUNT_ALLOCATIONS
+void* operator new(std::size_t in_size)
+{
+  ++hax::stats::heap_allocations;
+
+  void* mem = std::malloc(in_size ? in_size : 1);
+  if (!mem)
+    throw std::bad_alloc();
+
+  return mem;
+}
+
+void* operator new[](std::size_t in_size)
+{
+  return operator new(in_size);
+}
+
+void operator delete(void* in_mem) noexcept
+{
+  std::free(in_mem);
+}
+
+void operator delete[](void* in_mem) noexcept
+{
+  std::free(in_mem);
+}
+
+void operator delete(void* in_mem, std::size_t) noexcept
+{
+  std::free(in_mem);
+}
+
+void operator delete[](void* in_mem, std::size_t) noexcept
+{
+  std::free(in_mem);
+}
+#endif // HAX_COUNT_ALLOCATIONS
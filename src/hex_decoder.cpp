@@ -0,0 +1,122 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hex_decoder.hpp"
+#include <cassert>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+# define HAX_HEX_X86 1
+# include <emmintrin.h>
+#endif
+
+namespace hax
+{
+  const size_t hex_decoder::vector_threshold = 16;
+
+  bool hex_decoder::decode(std::string_view in_hex, std::vector<uint8_t>& out)
+  {
+    out.resize((in_hex.size() + 1) / 2);
+
+    const char* digits = in_hex.data();
+    uint8_t* bytes = out.data();
+    if (in_hex.size() % 2)
+    {
+      int lo = utility::hex_digit(*digits++);
+      if (lo == -1)
+        return false;
+      *bytes++ = lo;
+    }
+
+    size_t count = in_hex.size() / 2;
+    if (count < vector_threshold)
+      return decode_pairs_scalar(digits, bytes, count);
+
+    bool valid = decode_pairs_sse2(digits, bytes, count);
+
+#ifndef NDEBUG
+    // the vectorized decoder must agree with the scalar one
+    std::vector<uint8_t> scalar(count);
+    assert(decode_pairs_scalar(digits, scalar.data(), count) == valid);
+    assert(!valid || std::memcmp(scalar.data(), bytes, count) == 0);
+#endif
+
+    return valid;
+  }
+
+  bool hex_decoder::decode_pairs_scalar(const char* in_digits, uint8_t* out, size_t in_count)
+  {
+    for (size_t i = 0; i < in_count; ++i)
+    {
+      int hi = utility::hex_digit(in_digits[2*i]);
+      int lo = utility::hex_digit(in_digits[2*i+1]);
+      if ((hi | lo) < 0)
+        return false;
+
+      out[i] = (hi << 4) | lo;
+    }
+
+    return true;
+  }
+
+  bool hex_decoder::decode_pairs_sse2(const char* in_digits, uint8_t* out, size_t in_count)
+  {
+#ifdef HAX_HEX_X86
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i below_0 = _mm_set1_epi8('0' - 1);
+    const __m128i above_9 = _mm_set1_epi8('9' + 1);
+    const __m128i below_a = _mm_set1_epi8('a' - 1);
+    const __m128i above_f = _mm_set1_epi8('f' + 1);
+    const __m128i digit_base = _mm_set1_epi8('0');
+    const __m128i alpha_base = _mm_set1_epi8('a' - 10);
+    const __m128i low_byte = _mm_set1_epi16(0x00FF);
+
+    size_t i = 0;
+    for (; i + 8 <= in_count; i += 8)
+    {
+      __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in_digits + 2*i));
+      __m128i folded = _mm_or_si128(chars, lower);
+
+      // characters past 0x7F compare as negative and fall in neither range
+      __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(chars, below_0), _mm_cmplt_epi8(chars, above_9));
+      __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(folded, below_a), _mm_cmplt_epi8(folded, above_f));
+      if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xFFFF)
+        return false;
+
+      __m128i nibbles = _mm_or_si128(
+        _mm_and_si128(is_digit, _mm_sub_epi8(chars, digit_base)),
+        _mm_and_si128(is_alpha, _mm_sub_epi8(folded, alpha_base)));
+
+      // every 16-bit lane holds the high nibble in its low byte and the low
+      // nibble in its high byte
+      __m128i bytes = _mm_or_si128(
+        _mm_slli_epi16(_mm_and_si128(nibbles, low_byte), 4),
+        _mm_srli_epi16(nibbles, 8));
+
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(bytes, zero));
+    }
+
+    return decode_pairs_scalar(in_digits + 2*i, out + i, in_count - i);
+#else
+    return decode_pairs_scalar(in_digits, out, in_count);
+#endif
+  }
+} // end of namespace
@@ -23,14 +23,13 @@
 #include "parser.hpp"
 #include "symbol_manager.hpp"
 #include "operand_factory.hpp"
+#include "tokenizer.hpp"
+#include <cstdlib>
 
 namespace hax
 {
-  using utility::stringify;
-
-	instruction::instruction(opcode_t in_opcode, string_t const& in_mnemonic, pblock_t* in_block)
+	instruction::instruction(opcode_t in_opcode, mnemonic_id_t in_mnemonic_id, pblock_t* in_block)
   : opcode_(in_opcode),
-    location_(0),
     length_(0),
     label_(0),
     pblock_(in_block),
@@ -39,26 +38,21 @@ namespace hax
     addr_mode_(addressing_mode::undefined),
     objcode_(0x000000),
     indexed_(false),
-    mnemonic_(in_mnemonic),
+    mnemonic_id_(in_mnemonic_id),
     objcode_width_(6),
-    assemblable_(true)
+    assemblable_(true),
+    store_(0),
+    handle_(instruction_store::nil)
   {
 	}
 
 	instruction::~instruction()
 	{
+    // the operand and relocation records belong to the arena of the section
     pblock_ = 0;
     label_ = 0;
-    if (!operand_->is_symbol())
-      delete operand_;
-
-    while (!reloc_recs_.empty())
-    {
-      delete reloc_recs_.back();
-      reloc_recs_.pop_back();
-    }
-
     operand_ = 0;
+    reloc_recs_.clear();
 	}
 
   instruction::instruction(const instruction& src)
@@ -77,7 +71,9 @@ namespace hax
   void instruction::copy_from(const instruction& src)
   {
     this->opcode_ = src.opcode_;
-    this->location_ = src.location_;
+    this->mnemonic_id_ = src.mnemonic_id_;
+    this->store_ = src.store_;
+    this->handle_ = src.handle_;
     this->label_ = src.label_;
     //~ this->operand_str_ = src.operand_str_;
     this->format_ = src.format_;
@@ -94,9 +90,10 @@ namespace hax
 
   void instruction::assign_location(loc_t in_loc)
   {
-    if (location_ != in_loc && location_ != 0x0)
-      std::cout << "** LOCATION BEING REASSIGNED from: " << location_ << " to " << in_loc << "\n";;
-    location_ = in_loc;
+    loc_t current = location();
+    if (current != in_loc && current != 0x0)
+      std::cout << "** LOCATION BEING REASSIGNED from: " << current << " to " << in_loc << "\n";;
+    store_->assign_location(handle_, in_loc);
 
     if (label_)
     {
@@ -112,40 +109,47 @@ namespace hax
     //parser::singleton().current_section()->symmgr()->declare(label_->label(), location());
   }
 
-  void instruction::assign_operand(string_t const& in_token)
+  status_t instruction::assign_operand(std::string_view in_token, uint8_t in_flags)
   {
-    string_t operand_str = in_token;
+    std::string_view operand_str = in_token;
 
     // is it an indexed instruction?
-    if (operand_str.find(",X") != std::string::npos)
+    if (in_flags & entry_t::f_indexed)
     {
       indexed_ = true;
-      operand_str = operand_str.substr(0, operand_str.size()-2);
+      operand_str.remove_suffix(2);
     }
 
     // create the operand object
-    operand_ = operand_factory::singleton().create(operand_str, this);
+    return operand_factory::singleton().create(operand_str, this, operand_);
   }
   void instruction::assign_operand(operand* in_operand)
   {
     operand_ = in_operand;
   }
 
+  format_t instruction::format() const
+  {
+    return format_;
+  }
+
   loc_t instruction::location() const
   {
-    return location_;
+    return store_ ? store_->location(handle_) : 0;
   }
 
-  void instruction::preprocess()
+  status_t instruction::preprocess()
   {
     if (label_)
       label_->assign_address(location());
+
+    return status_t();
   }
 
   std::ostream& instruction::to_stream(std::ostream& out) const
   {
     out << std::uppercase;
-    out << std::hex << std::setw(4) << std::setfill('0') << (int)location_;
+    out << std::hex << std::setw(4) << std::setfill('0') << (int)location();
     out << "\t";
 
     if (label_)
@@ -155,7 +159,7 @@ namespace hax
       out << "\t";
 
     out << "\t";
-    out << mnemonic_;
+    out << mnemonic();
     if (format_ != format::fmt_directive)
       out << "\t(0x" << std::hex << std::setw(2) << std::setfill('0') << (int)opcode_ << ")";
     else
@@ -170,7 +174,13 @@ namespace hax
         out << "\t";
     }
 
-    if (objcode_ || (operand_ && operand_->is_evaluated()))
+    byte_span_t bytes = data();
+    if (bytes.length)
+    {
+      out << "\t\t";
+      utility::write_hex(out, bytes.data, bytes.length);
+    }
+    else if (objcode_ || (operand_ && operand_->is_evaluated()))
       out << "\t\t" << std::hex << std::setw(objcode_width_) << std::setfill('0') << objcode_;
 
     if (is_relocatable())
@@ -188,13 +198,13 @@ namespace hax
     out << "Instruction:\n";
     out << "\tLine: " << line_ << "\n";
     out << "\tOpcode: 0x" << std::hex << std::setw(2) << std::setfill('0') << (int)opcode_ << std::endl;
-    out << "\tLocation: 0x" << std::hex << std::setw(3) << std::setfill('0') << (int)location_ << std::endl;
+    out << "\tLocation: 0x" << std::hex << std::setw(3) << std::setfill('0') << (int)location() << std::endl;
     out << "\tLabel: " << (label_ ? label_->token() : "undefined") << "\n";
 
     return out.str();
   }
 
-  void instruction::assign_line(string_t const& in_entry)
+  void instruction::assign_line(std::string_view in_entry)
   {
     line_ = in_entry;
   }
@@ -209,6 +219,11 @@ namespace hax
     return objcode_;
   }
 
+  byte_span_t instruction::data() const
+  {
+    return { 0, 0 };
+  }
+
   bool instruction::is_assemblable() const
   {
     return assemblable_;
@@ -219,9 +234,16 @@ namespace hax
     return !reloc_recs_.empty();
   }
 
-  string_t const& instruction::mnemonic() const
+  mnemonic_id_t instruction::mnemonic_id() const
   {
-    return mnemonic_;
+    return mnemonic_id_;
+  }
+
+  string_t instruction::mnemonic() const
+  {
+    string_t out(format_ == format::fmt_four ? "+" : "");
+    out += optable::get(mnemonic_id_).mnemonic;
+    return out;
   }
 
   instruction::reloc_records_t&
@@ -230,58 +252,26 @@ namespace hax
     return reloc_recs_;
   }
 
-  void instruction::construct_relocation_records()
+  status_t instruction::construct_relocation_records()
   {
     if (!operand_)
-      return;
+      return status_t();
 
-    // if the operand is an expression, we need to go through all its sub-operands,
-    // check if they're an external reference, and if so, add a relocation record
+    // if the operand is an expression, every external reference that is left
+    // once the ones cancelling each other out are dropped needs a record per
+    // time it is added or subtracted
     if (operand_->is_expression())
     {
-      expression* expr = static_cast<expression*>(operand_);
+      expression::terms_t terms;
+      status_t result = static_cast<expression*>(operand_)->relocation_terms(terms);
 
-      std::map<string_t, size_t> index;
+      // shared expressions are not tied to any one line, point at this one
+      if (!result.ok())
+        return status_t::failure(invalid_expression(result.error().what(), line()));
 
-      string_t infix = utility::remove_in_string(expr->token(), ' ');
-      for (auto ref : expr->references())
-      {
-        char sign = '+';
-        if (ref->is_external_ref())
-        {
-          // scan the infix expression for this symbol and find its operator
-
-          // register the symbol if it's the first time we're scanning for it
-          size_t offset = 0;
-          if (index.find(ref->token()) == index.end())
-            index.insert(std::make_pair(ref->token(), 0));
-          else
-            offset = index[ref->token()]; // use the last saved offset
-
-          // find the next occurence of this symbol
-          size_t pos = infix.find(ref->token(), offset);
-
-          // if pos == 0, then the sign is positive
-          if (pos != 0) {
-            if (infix[pos-1] == '-') sign = '-';
-            else if (infix[pos-1] == '+' || infix[pos-1] == '(') sign = '+';
-            else
-              throw invalid_operand("can not evaluate the sign of external reference '"
-              + ref->token() + "' in expression: " + infix, line_);
-          }
-
-          // save the last position we found this token at, so if there's another
-          // reference to it, we'll be at the correct offset
-          index[ref->token()] = pos;
-
-          // finally, save the record
-          reloc_record_t* rec = construct_relocation_record(ref);
-          rec->value[0] = sign;
-          reloc_recs_.push_back(rec);
-
-          std::cout << "** created a reloc record for expression: " << rec->value << "\n";
-        }
-      }
+      for (auto const& term : terms)
+        for (int32_t i = 0; i < std::abs(term.weight); ++i)
+          reloc_recs_.push_back(construct_relocation_record(term.symbol, term.weight < 0));
     }
 
     // if the operand is an external reference to a symbol, then it's straight-forward
@@ -291,31 +281,39 @@ namespace hax
       symbol_t* sym = static_cast<symbol*>(operand_);
       if (sym->is_external_ref())
       {
-        reloc_recs_.push_back(construct_relocation_record(sym));
+        reloc_recs_.push_back(construct_relocation_record(sym->id()));
       }
       //~ std::cout << " => " << reloc_recs_.size() << "\n";
     }
     else {
       //~ std::cout << "warn: unknown type of expression for relocation evaluation: " << line_ << "\n";
     }
+
+    return status_t();
   }
 
-  instruction::reloc_record_t* instruction::construct_relocation_record(symbol_t* sym)
+  instruction::reloc_record_t instruction::construct_relocation_record(symbol_id_t sym, bool negative) const
   {
-    reloc_record_t* rec = new reloc_record_t();
-    rec->value = "+" + sym->token();
-    rec->length = (format_ == format::fmt_four) ? 0x05 : 0x06; // TODO: verify this
+    reloc_record_t rec;
+    rec.symbol = sym;
+    rec.length = (format_ == format::fmt_four) ? 0x05 : 0x06; // TODO: verify this
+    rec.negative = negative;
     return rec;
   }
 
-  void instruction::postprocess()
+  status_t instruction::postprocess()
   {
-    construct_relocation_records();
+    status_t result = construct_relocation_records();
+    if (!result.ok())
+      return result;
+
     if (operand_ && operand_->is_symbol()) {
       symbol* sym = static_cast<symbol*>(operand_);
       if (is_assemblable() && !sym->is_evaluated() && !sym->is_external_ref())
-        throw undefined_symbol(sym->token());
+        return status_t::failure(undefined_symbol(string_t(sym->token())));
     }
+
+    return result;
   }
 
   operand* instruction::get_operand() const { return operand_; }
@@ -325,13 +323,24 @@ namespace hax
     return pblock_;
   }
 
-  string_t const& instruction::line() const
+  string_t instruction::line() const
   {
-    return line_;
+    return string_t(line_);
   }
 
   void instruction::__assign_block(program_block* block)
   {
     pblock_ = block;
   }
+
+  void instruction::__assign_handle(instruction_store* store, instruction_store::handle_t handle)
+  {
+    store_ = store;
+    handle_ = handle;
+  }
+
+  instruction_store::handle_t instruction::handle() const
+  {
+    return handle_;
+  }
 } // end of namespace
@@ -20,6 +20,7 @@
 
 #include "instruction_factory.hpp"
 #include "parser.hpp"
+#include "control_section.hpp"
 
 namespace hax
 {
@@ -44,47 +45,49 @@ namespace hax
 		return *singleton_ptr();
 	}
 
-  instruction_t*
-  instruction_factory::create(string_t const& in_token, program_block *in_block)
+  status_t
+  instruction_factory::create(entry_t const& in_entry, program_block *in_block, instruction_t*& out_inst)
   {
-    int ec = -1;
-    opcode_fmt_t tuple = parser::singleton().opcode_from_token(in_token, &ec);
+    const op_t* op = in_entry.op;
+    if (!op)
+      return status_t::failure(unrecognized_operation("attempting to create an instruction of an unrecognized operation: " + string_t(in_entry.mnemonic()), in_block->name()));
 
-    if (ec != 0)
-      throw unrecognized_operation("attempting to create an instruction of an unrecognized operation: " + in_token, in_block->name());
+    arena_t& mem = in_block->sect()->arena();
 
     instruction_t *inst = 0;
-    opcode_t opcode = std::get<0>(tuple);
-    switch (std::get<1>(tuple))
+    opcode_t opcode = op->code;
+    mnemonic_id_t mnemonic = op->id;
+    switch (op->fmt)
     {
       case format::fmt_one:
-        inst = new fmt1_instruction(opcode, in_token, in_block);
+        inst = mem.create<fmt1_instruction>(opcode, mnemonic, in_block);
         break;
       case format::fmt_two:
-        inst = new fmt2_instruction(opcode, in_token, in_block);
+        inst = mem.create<fmt2_instruction>(opcode, mnemonic, in_block);
         break;
       case format::fmt_three | format::fmt_four:
       case format::fmt_three:
       case format::fmt_four:
         // is it an extended one? (fmt4)
-        if (in_token.front() == '+')
+        if (in_entry.flags & entry_t::f_extended)
         {
           // fmt4
-          inst = new fmt4_instruction(opcode, in_token, in_block);
+          inst = mem.create<fmt4_instruction>(opcode, mnemonic, in_block);
         } else
         {
           // fmt3
-          inst = new fmt3_instruction(opcode, in_token, in_block);
+          inst = mem.create<fmt3_instruction>(opcode, mnemonic, in_block);
         }
         break;
       case format::fmt_directive:
-        inst = new directive(opcode, in_token, in_block);
+        inst = mem.create<directive>(opcode, mnemonic, in_block);
         break;
       default:
-        std::cerr << "warning: attempting to create an instruction of an unknown format! " << std::get<1>(tuple) << ", aborting\n";
+        std::cerr << "warning: attempting to create an instruction of an unknown format! " << (int)op->fmt << ", aborting\n";
     }
 
-    return inst;
+    out_inst = inst;
+    return status_t();
   }
 
 } // end of namespace
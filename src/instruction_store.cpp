@@ -0,0 +1,99 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "instruction_store.hpp"
+#include "instruction.hpp"
+
+namespace hax
+{
+  const instruction_store::handle_t instruction_store::nil = 0xFFFFFFFF;
+
+  instruction_store::instruction_store()
+  {
+  }
+
+  instruction_store::~instruction_store()
+  {
+    // the instructions themselves are released by the arena of the section
+    instructions_.clear();
+  }
+
+  instruction_store::handle_t
+  instruction_store::add(instruction_t* in_inst, uint16_t in_block)
+  {
+    handle_t handle = static_cast<handle_t>(instructions_.size());
+
+    instructions_.push_back(in_inst);
+    mnemonic_ids_.push_back(in_inst->mnemonic_id());
+    formats_.push_back(in_inst->format());
+    flags_.push_back(in_inst->label() ? f_labelled : 0);
+    blocks_.push_back(in_block);
+    locations_.push_back(0);
+    lengths_.push_back(0);
+    operands_.push_back(0);
+    objcodes_.push_back(0);
+
+    in_inst->__assign_handle(this, handle);
+    return handle;
+  }
+
+  void instruction_store::record_pass1(handle_t i)
+  {
+    instruction_t const* inst = instructions_[i];
+
+    formats_[i] = inst->format();
+    lengths_[i] = inst->length();
+    operands_[i] = inst->get_operand();
+
+    if (inst->is_assemblable())
+      flags_[i] |= f_assemblable;
+    else
+      flags_[i] &= ~f_assemblable;
+  }
+
+  void instruction_store::record_pass2(handle_t i)
+  {
+    instruction_t* inst = instructions_[i];
+
+    objcodes_[i] = inst->objcode();
+
+    if (inst->is_relocatable())
+      flags_[i] |= f_relocatable;
+
+    if (inst->data().length)
+      flags_[i] |= f_data;
+  }
+
+  void instruction_store::relocate(std::vector<loc_t> const& in_offsets)
+  {
+    const size_t count = instructions_.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+      loc_t offset = in_offsets[blocks_[i]];
+      if (!offset)
+        continue;
+
+      if (flags_[i] & f_labelled)
+        instructions_[i]->assign_location(locations_[i] + offset);
+      else
+        locations_[i] += offset;
+    }
+  }
+} // end of namespace
@@ -22,15 +22,15 @@
 #include "parser.hpp"
 #include "symbol_manager.hpp"
 #include "operands/expression.hpp"
+#include "operands/constant.hpp"
 #include <cassert>
 
 namespace hax
 {
   extern bool VERBOSE;
-  using utility::stringify;
 
-	directive::directive(opcode_t in_opcode, string_t const& in_mnemonic, pblock_t* block)
-  : instruction(in_opcode, in_mnemonic, block)
+	directive::directive(opcode_t in_opcode, mnemonic_id_t in_mnemonic_id, pblock_t* block)
+  : instruction(in_opcode, in_mnemonic_id, block)
   {
     format_ = format::fmt_directive;
 	}
@@ -58,128 +58,194 @@ namespace hax
     instruction::copy_from(src);
   }
 
-  void directive::preprocess()
+  status_t directive::preprocess()
   {
-    instruction::preprocess();
+    status_t result = instruction::preprocess();
+    if (!result.ok())
+      return result;
+
     length_ = 0;
 
     assemblable_ = false;
     symbol_manager* symmgr = pblock_->sect()->symmgr();
 
-    if (mnemonic_ == "BYTE" || mnemonic_ == "WORD")
+    // USE, LTORG and END may do without an operand, the rest work on theirs
+    switch (mnemonic_id_)
     {
-      // BYTE and WORD directive operands need be either immediate constants, or a constant
-      // absolute expression
-      if (!operand_->is_constant() && !operand_->is_expression())
-        throw invalid_operand(mnemonic_ + " directives operands can only be constant decimal integers", line_);
+      case m_byte:
+      case m_word:
+      case m_resb:
+      case m_resw:
+      case m_base:
+      case m_equ:
+      case m_extref:
+      case m_extdef:
+        if (!operand_)
+          return status_t::failure(invalid_operand(mnemonic() + " directives require an operand", line()));
+        break;
+
+      default:
+        break;
+    }
 
-      bool is_word = mnemonic_ == "WORD";
-      operand_->evaluate();
-      if (is_word)
-        length_ = 3;
-      else
-        length_ = operand_->length();
+    switch (mnemonic_id_)
+    {
+      case m_byte:
+      case m_word:
+      {
+        // BYTE and WORD directive operands need be either immediate constants, or a constant
+        // absolute expression
+        if (!operand_->is_constant() && !operand_->is_expression())
+          return status_t::failure(invalid_operand(mnemonic() + " directives operands can only be constant decimal integers", line()));
+
+        bool is_word = mnemonic_id_ == m_word;
+        result = operand_->evaluate();
+        if (!result.ok())
+          return result;
+
+        if (is_word)
+          length_ = 3;
+        else
+          length_ = operand_->length();
+
+        assemblable_ = true;
+        break;
+      }
 
-      assemblable_ = true;
+      case m_resb:
+      case m_resw:
+      {
+        result = operand_->evaluate();
+        if (!result.ok())
+          return result;
+
+        if (operand_->is_expression() && !operand_->is_evaluated())
+          return status_t::failure(invalid_operand("expressions in RESB and RESW operands must be evaluated", line()));
+
+        // widened so that a large count can not wrap the location counter
+        // before the block gets to check it against the address space
+        bool is_word = mnemonic_id_ == m_resw;
+        uint64_t reserved = uint64_t(is_word ? 3 : 1) * operand_->value();
+        if (reserved > address_space)
+          return status_t::failure(address_overflow(
+            mnemonic() + " reserves more than the 20-bit address space", line()));
+
+        length_ = reserved;
+
+        // assign the value of the label as the number of bytes/words reserved
+        if (label_) {
+          //~ label_->_assign_value(operand_->value());
+        }
+        break;
+      }
 
-    } else if (mnemonic_ == "RESB" || mnemonic_ == "RESW") {
+      case m_base:
+        break;
 
-      operand_->evaluate();
-      if (operand_->is_expression() && !operand_->is_evaluated())
-        throw invalid_operand("expressions in RESB and RESW operands must be evaluated", line_);
+      case m_equ:
+      {
+        length_ = 0;
 
-      bool is_word = mnemonic_ == "RESW";
-      length_ = (is_word ? 3 : 1) * operand_->value();
+        if (!label_)
+          return status_t::failure(invalid_entry("EQU directives must be labelled", line()));
 
-      // assign the value of the label as the number of bytes/words reserved
-      if (label_) {
-        //~ label_->_assign_value(operand_->value());
-      }
+        // the label only counts as defined once its value is known, which also
+        // keeps an operand that refers back to the label from resolving
+        label_->__withdraw();
 
-    } else if (mnemonic_ == "BASE") {
+        // symbols that are defined further down are only known once all the
+        // entries have been read
+        bool resolved = true;
+        if (operand_->is_symbol())
+          resolved = operand_->is_evaluated();
+        else if (operand_->is_expression())
+          for (auto sym : static_cast<expression*>(operand_)->references())
+            resolved = resolved && sym->is_evaluated();
 
-    } else if (mnemonic_ == "EQU") {
-      length_ = 0;
+        if (resolved)
+          return __define();
 
-      try {
-        operand_->evaluate();
-        label_->_assign_value(operand_->value());
-        label_->set_user_defined(true);
-        //~ label_->assign_address(operand_->value());
-      } catch (unevaluated_operand& e) {
-        std::cerr << "Warning: " << e.what() << "\n";
+        symmgr->defer_definition(this);
+        break;
       }
 
-      if (operand_->is_symbol())
-        static_cast<symbol*>(operand_)->set_user_defined(true);
+      case m_use:
+      {
+        std::string block_name;
+        if (!operand_)
+          block_name = "Unnamed";
+        else
+          block_name = string_t(operand_->token());
 
-      if (!operand_->is_evaluated()) {
-        string_t msg = "EQU operands must be either constant decimal integers, ";
-        msg += "previously defined symbols, or expressions of previously defined symbols";
-        throw invalid_operand(msg.c_str(), line_);
+        pblock_->sect()->switch_to_block(block_name);
+        break;
       }
 
-    } else if (mnemonic_ == "USE") {
-      std::string block_name;
-      if (!operand_)
-        block_name = "Unnamed";
-      else
-        block_name = operand_->token();
-
-      pblock_->sect()->switch_to_block(block_name);
-    } /*else if (mnemonic_ == "START" || mnemonic_ == "CSECT")
-    {
-      if (!operand_ || operand_->token().empty())
-        throw invalid_operand(mnemonic_ + " entries must contain a name operand");
-
-      parser::singleton().__register_section(operand_->token());
-    }*/
-    else if (mnemonic_ == "EXTREF") {
-      std::vector<std::string> tokens = utility::split(operand_->token(), ',');
-      for (auto token : tokens) {
-        symbol_t* sym = symmgr->declare(token);
-        symmgr->define(sym, 0x0, true /* assign both value and address to 0 */);
-        sym->set_external_ref(true);
+      case m_extref:
+      {
+        std::vector<std::string> tokens = utility::split(string_t(operand_->token()), ',');
+        for (auto token : tokens) {
+          if (symbol_manager::builtin(token))
+            return status_t::failure(invalid_operand("built-in symbol '" + token + "' can not be an external reference", line()));
+
+          symbol_t* sym = symmgr->declare(token);
+          symmgr->define(sym, 0x0, true /* assign both value and address to 0 */);
+          sym->set_external_ref(true);
+        }
+
+        symmgr->__undefine(operand_->token());
+        operand_ = 0;
+        break;
       }
 
-      symmgr->__undefine(operand_->token());
-      operand_ = 0;
-    } else if (mnemonic_ == "EXTDEF") {
-      std::cout << "Registering external symbol definitions:";
+      case m_extdef:
+      {
+        std::cout << "Registering external symbol definitions:";
 
-      //~ std::vector<std::string> tokens = ;
-      for (auto token : utility::split(operand_->token(), ',')) {
-        symbol_t* sym = symmgr->declare(token);
-        sym->set_external_def(true);
+        for (auto token : utility::split(string_t(operand_->token()), ',')) {
+          if (symbol_manager::builtin(token))
+            return status_t::failure(invalid_operand("built-in symbol '" + token + "' can not be an external definition", line()));
 
-        std::cout << sym->token() << " ";
+          symbol_t* sym = symmgr->declare(token);
+          sym->set_external_def(true);
+
+          std::cout << sym->token() << " ";
+        }
+        std::cout << "\n";
+
+        symmgr->__undefine(operand_->token());
+        operand_ = 0;
+        break;
       }
-      std::cout << "\n";
-
-      symmgr->__undefine(operand_->token());
-      operand_ = 0;
-    } else if (mnemonic_ == "LTORG") {
-      pblock_->sect()->symmgr()->dump_literal_pool();
-      //~ symmgr->dump_literal_pool();
-    } else if (mnemonic_ == "END")
-    {
-      // if no starting instruction was assigned, just leave the control section's
-      // starting address as 0x0
-      if (!(operand_ && operand_->is_evaluated()))
-        return;
 
-      // extract the location of the instruction
-      symbol_manager *symmgr = pblock_->sect()->symmgr();
-      symbol_t *oper = symmgr->lookup(operand_->token());
+      case m_ltorg:
+        return pblock_->sect()->symmgr()->dump_literal_pool();
+
+      case m_end:
+      {
+        // if no starting instruction was assigned, just leave the control section's
+        // starting address as 0x0
+        if (!(operand_ && operand_->is_evaluated()))
+          return result;
 
-      if (!oper)
-        throw undefined_symbol("in END instruction: " + operand_->token());
+        // extract the location of the instruction
+        symbol_t *oper = symmgr->lookup(operand_->token());
+
+        if (!oper)
+          return status_t::failure(undefined_symbol("in END instruction: " + string_t(operand_->token())));
+
+        objcode_ = oper->address();
+        pblock_->sect()->assign_starting_address(objcode_);
+        break;
+      }
 
-      objcode_ = oper->address();
-      pblock_->sect()->assign_starting_address(objcode_);
+      // START and CSECT are handled by the parser when the entry is read
+      default:
+        break;
     }
 
     //~ construct_relocation_records();
+    return result;
   }
 
   loc_t directive::length() const
@@ -187,29 +253,70 @@ namespace hax
     return length_;
   }
 
-  void directive::assemble()
+  status_t directive::assemble()
   {
-    if (mnemonic_ == "BASE")
+    switch (mnemonic_id_)
     {
-      //~ std::cout << "-- assigned base register @ ";
-      //symbol_t *operand = symbol_manager::singleton().lookup(operand_str_);
-      //assert(operand);
-      parser::singleton().set_base(operand_->value());
-
-      if (VERBOSE)
-      std::cout
-        << "-- base register assigned @ "
-        << std::hex << std::setw(4) << std::setfill('0') << parser::singleton().base()
-        << "\n";
-
-    } else if (mnemonic_ == "BYTE" || mnemonic_ == "WORD")
-    {
-      // BYTE constant values have already been evaluated in preprocess()
-      if (!operand_->is_evaluated())
-        operand_->evaluate();
-      objcode_ = operand_->value();
-      objcode_width_ = operand_->length() * 2;
+      case m_base:
+      {
+        // the operand may be the location counter, or an expression that
+        // refers to symbols defined further down
+        status_t result = operand_->evaluate();
+        if (!result.ok())
+          return result;
+
+        parser::singleton().set_base(operand_->value());
+
+        if (VERBOSE)
+        std::cout
+          << "-- base register assigned @ "
+          << std::hex << std::setw(4) << std::setfill('0') << parser::singleton().base()
+          << "\n";
+        break;
+      }
+
+      case m_byte:
+      case m_word:
+        // BYTE constant values have already been evaluated in preprocess()
+        if (!operand_->is_evaluated())
+        {
+          status_t result = operand_->evaluate();
+          if (!result.ok())
+            return result;
+        }
+        objcode_ = operand_->value();
+        objcode_width_ = data().length ? 0 : operand_->length() * 2;
+        break;
+
+      default:
+        break;
     }
+
+    return status_t();
+  }
+
+  status_t directive::__define()
+  {
+    status_t result = operand_->evaluate();
+    if (!result.ok())
+      return result;
+
+    label_->_assign_value(operand_->value());
+    label_->set_user_defined(true);
+
+    // built-in symbols are shared by all sections and are left untouched
+    if (operand_->is_symbol() && !symbol_manager::is_builtin(static_cast<symbol*>(operand_)->id()))
+      static_cast<symbol*>(operand_)->set_user_defined(true);
+
+    return result;
+  }
+
+  byte_span_t directive::data() const
+  {
+    if (mnemonic_id_ != m_byte || !operand_ || !operand_->is_constant())
+      return { 0, 0 };
+
+    return static_cast<constant*>(operand_)->bytes();
   }
 
   bool directive::is_valid() const
@@ -22,10 +22,8 @@
 
 namespace hax
 {
-  using utility::stringify;
-
-	fmt1_instruction::fmt1_instruction(opcode_t in_opcode, string_t const& in_mnemonic, pblock_t* block)
-  : instruction(in_opcode, in_mnemonic, block)
+	fmt1_instruction::fmt1_instruction(opcode_t in_opcode, mnemonic_id_t in_mnemonic_id, pblock_t* block)
+  : instruction(in_opcode, in_mnemonic_id, block)
   {
     format_ = format::fmt_one;
 	}
@@ -58,8 +56,9 @@ namespace hax
     return 1;
   }
 
-  void fmt1_instruction::assemble()
+  status_t fmt1_instruction::assemble()
   {
+    return status_t();
   }
 
   bool fmt1_instruction::is_valid() const
@@ -22,14 +22,13 @@
 #include "symbol.hpp"
 #include "parser.hpp"
 #include "symbol_manager.hpp"
+#include "encoders.hpp"
 #include <cassert>
 
 namespace hax
 {
-  using utility::stringify;
-
-	fmt2_instruction::fmt2_instruction(opcode_t in_opcode, string_t const& in_mnemonic, pblock_t* block)
-  : instruction(in_opcode, in_mnemonic, block),
+	fmt2_instruction::fmt2_instruction(opcode_t in_opcode, mnemonic_id_t in_mnemonic_id, pblock_t* block)
+  : instruction(in_opcode, in_mnemonic_id, block),
     lhs_(0),
     rhs_(0)
   {
@@ -67,36 +66,35 @@ namespace hax
     return 2;
   }
 
-  void fmt2_instruction::assign_operand(string_t const& in_token)
+  status_t fmt2_instruction::assign_operand(std::string_view in_token, uint8_t in_flags)
   {
     symbol_manager *symmgr = pblock_->sect()->symmgr();
 
-    std::vector<string_t> operands;
-
-    // we have to split the operands, if there's more than one
-    bool has_two_operands = in_token.find(",") != std::string::npos;
-    if (has_two_operands)
+    // we have to split the operands, if there's more than one; a register
+    // operand never carries addressing flags so in_flags is not consulted
+    size_t delim = in_token.find(',');
+    if (delim != std::string_view::npos)
     {
-      operands = utility::split(in_token, ',');
-      assert(operands.size() == 2);
+      assert(in_token.find(',', delim + 1) == std::string_view::npos);
+      lhs_ = symmgr->declare(in_token.substr(0, delim));
+      rhs_ = symmgr->declare(in_token.substr(delim + 1));
     } else {
-
-      operands.push_back(in_token);
-      operands.push_back("0"); // second register is nil
+      lhs_ = symmgr->declare(in_token);
+      rhs_ = symmgr->declare("0"); // second register is nil
     }
 
-    lhs_ = symmgr->declare(operands.front());
-    rhs_ = symmgr->declare(operands.back());
+    return status_t();
   }
 
-  void fmt2_instruction::assemble()
+  status_t fmt2_instruction::assemble()
   {
-    lhs_->evaluate();
-    rhs_->evaluate();
+    // both operands are symbols, which hold their values once defined and
+    // have nothing to evaluate
+    if (!encoding::fmt2::fits(lhs_->value()) || !encoding::fmt2::fits(rhs_->value()))
+      return status_t::failure(invalid_operand("format 2 operands must be registers or counts between 0 and 15", line()));
 
-    std::stringstream target_address;
-    target_address << std::hex << (int)opcode_ << lhs_->value() << rhs_->value();
-    target_address >> objcode_;
+    objcode_ = encoding::fmt2::encode(opcode_, lhs_->value(), rhs_->value());
+    return status_t();
   }
 
   bool fmt2_instruction::is_valid() const
@@ -22,14 +22,15 @@
 #include "symbol.hpp"
 #include "parser.hpp"
 #include "symbol_manager.hpp"
+#include "tokenizer.hpp"
+#include "encoders.hpp"
 #include <cassert>
 
 namespace hax
 {
-  using utility::stringify;
-
-	fmt3_instruction::fmt3_instruction(opcode_t in_opcode, string_t const& in_mnemonic, pblock_t* block)
-  : instruction(in_opcode, in_mnemonic, block)
+	fmt3_instruction::fmt3_instruction(opcode_t in_opcode, mnemonic_id_t in_mnemonic_id, pblock_t* block)
+  : instruction(in_opcode, in_mnemonic_id, block),
+    by_address_(false)
   {
     format_ = format::fmt_three;
     addr_mode_ = addressing_mode::simple;
@@ -56,21 +57,25 @@ namespace hax
   void fmt3_instruction::copy_from(const fmt3_instruction& src)
   {
     instruction::copy_from(src);
+    by_address_ = src.by_address_;
   }
 
-  void fmt3_instruction::preprocess()
+  status_t fmt3_instruction::preprocess()
   {
-    instruction::preprocess();
+    status_t result = instruction::preprocess();
+    if (!result.ok())
+      return result;
 
     length_ = 3;
 
-    if (mnemonic_ == "RSUB")
+    if (mnemonic_id_ == m_rsub)
     {
       //if (operands_.empty())
       //  operands_.push_back("0");
-      assign_operand("0");
+      result = assign_operand("0", 0);
     }
 
+    return result;
   }
 
   loc_t fmt3_instruction::length() const
@@ -78,113 +83,73 @@ namespace hax
     return length_;
   }
 
-  void fmt3_instruction::assign_operand(string_t const& in_operand)
+  status_t fmt3_instruction::assign_operand(std::string_view in_operand, uint8_t in_flags)
   {
-    instruction::assign_operand(in_operand);
-
-    switch(in_operand[0]) {
-      case '#':
-        addr_mode_ = addressing_mode::immediate;
-        break;
-      case '@':
-        addr_mode_ = addressing_mode::indirect;
-        break;
-      default:
-        addr_mode_ = addressing_mode::simple;
-    }
+    status_t result = instruction::assign_operand(in_operand, in_flags);
+    if (!result.ok())
+      return result;
+
+    if (in_flags & entry_t::f_immediate)
+      addr_mode_ = addressing_mode::immediate;
+    else if (in_flags & entry_t::f_indirect)
+      addr_mode_ = addressing_mode::indirect;
+    else
+      addr_mode_ = addressing_mode::simple;
+
+    // symbols are targeted by their address unless they are used as immediate values
+    by_address_ = operand_->is_symbol() && addr_mode_ != addressing_mode::immediate;
+    return result;
   }
 
-  bool fmt3_instruction::pc_relative_viable(int& address) const
+  status_t fmt3_instruction::assemble()
   {
-    int lower_bound = -2048 + location();
-    int upper_bound = 2047 + location();
-
-    return !(address < lower_bound || address > upper_bound);
+    // a batch of one, so there is a single format 3 encoding path
+    encoding::fmt3_batch batch;
+    status_t result = gather(batch);
+    if (!result.ok())
+      return result;
+
+    batch.encode();
+    return assign_objcode(batch.objcode_at(0), batch.target_at(0));
   }
 
-  bool fmt3_instruction::base_relative_viable(int& address) const
+  status_t fmt3_instruction::gather(encoding::fmt3_batch& out_batch)
   {
-    loc_t base = parser::singleton().base();
-
-    int lower_bound = 0 + base;
-    int upper_bound = 4096 + base;
-
-    //std::cout
-    //  << "\tchecking if address is viable for base-relative targeting: "
-    //  << std::hex << address << " <> base: " << base << "\n";
-
-    return !(address < lower_bound || address > upper_bound);
+    int target_address;
+    status_t result = evaluate_target(target_address);
+    if (!result.ok())
+      return result;
+
+    out_batch.add(this, opcode_, addr_mode_, indexed_, operand_->is_constant(),
+      target_address, location() + length(), parser::singleton().base());
+    return result;
   }
 
-  bool fmt3_instruction::immediate_viable(int& address) const
+  status_t fmt3_instruction::evaluate_target(int& out_target)
   {
-    // since SIC/XE is not a multi-programming architecture, a program
-    // is allowed to reference all memory locations which is [0 ... 2^20]
-    int lower_bound = 0;
-    int upper_bound = 1048576;
-
-    return !(address < lower_bound || address > upper_bound);
+    status_t result = operand_->evaluate();
+    if (!result.ok())
+      return result;
+
+    out_target = by_address_
+      ? static_cast<symbol*>(operand_)->address()
+      : operand_->value();
+    return result;
   }
 
-  void fmt3_instruction::assemble()
+  status_t fmt3_instruction::assign_objcode(objcode_t in_objcode, int in_target)
   {
-    int target_address = 0x0;
-    int disp = 0x0;
-    uint16_t targeting_flags = 0x0;
-    operand_->evaluate();
-    if (addr_mode_ != addressing_mode::immediate && operand_->is_symbol())
-      disp = target_address = static_cast<symbol*>(operand_)->address();
-    else
-      disp = target_address = operand_->value();
+    if (in_objcode == encoding::out_of_bounds)
+      return status_t::failure(target_out_of_bounds(utility::to_string(in_target), line()));
 
-    if (indexed_)
-      targeting_flags |= 0x008000;
+    objcode_ = in_objcode;
 
-    // try calculating the displacement using PC, then base, then immediate addressing
-    if (!operand_->is_constant())
-    {
-      //~ construct_relocation_records();
-
-      if (pc_relative_viable(target_address))
-      {
-        disp = target_address - (location() + length());
-
-        if (VERBOSE)
-        std::cout
-          << "PC-relative displacement = " << std::hex << std::uppercase
-          << target_address << " - "
-          << (location() + length()) << " = " << disp << "\n";
-
-        targeting_flags |= 0x002000;
-      } else if (base_relative_viable(target_address))
-      {
-        disp = target_address - parser::singleton().base();
-
-        if (VERBOSE)
-        std::cout
-          << "Base-relative displacement = " << std::hex << std::uppercase
-          << target_address << " - "
-          << (location() + length()) << " = " << disp << "\n";
-
-        //~ targeting_flags |= indexed_ ? 0x00C000 : 0x004000;
-        targeting_flags |= 0x004000;
-      } else if (immediate_viable(target_address))
-      {
-        disp = target_address;
-
-        if (VERBOSE)
-        std::cout
-          << "Immediate target address = " << std::hex << std::uppercase
-          << target_address << "\n";
-
-      } else {
-        throw target_out_of_bounds(utility::stringify(target_address), this->line_);
-      }
-    }
+    if (VERBOSE)
+    std::cout
+      << "Fmt3 target address = " << std::hex << std::uppercase
+      << in_target << " encoded as " << objcode_ << "\n";
 
-    // discard the 5 highest-order half-bytes (for negative values calculated with 2's complement)
-    objcode_ = (opcode_ << 16) | addr_mode_ | targeting_flags;
-    objcode_ = utility::overwrite_bits<int>(disp, objcode_, 12, 20);
+    return status_t();
   }
 
   bool fmt3_instruction::is_valid() const
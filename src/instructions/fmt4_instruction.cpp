@@ -22,14 +22,14 @@
 #include "symbol.hpp"
 #include "parser.hpp"
 #include "symbol_manager.hpp"
+#include "tokenizer.hpp"
 #include <cassert>
 
 namespace hax
 {
-  using utility::stringify;
-
-	fmt4_instruction::fmt4_instruction(opcode_t in_opcode, string_t const& in_mnemonic, pblock_t* block)
-  : instruction(in_opcode, in_mnemonic, block)
+	fmt4_instruction::fmt4_instruction(opcode_t in_opcode, mnemonic_id_t in_mnemonic_id, pblock_t* block)
+  : instruction(in_opcode, in_mnemonic_id, block),
+    encoder_(0)
   {
     format_ = format::fmt_four;
     objcode_width_ = 8;
@@ -56,6 +56,7 @@ namespace hax
   void fmt4_instruction::copy_from(const fmt4_instruction& src)
   {
     instruction::copy_from(src);
+    encoder_ = src.encoder_;
   }
 
   loc_t fmt4_instruction::length() const
@@ -63,56 +64,39 @@ namespace hax
     return 4;
   }
 
-  void fmt4_instruction::assign_operand(string_t const& in_operand)
+  status_t fmt4_instruction::assign_operand(std::string_view in_operand, uint8_t in_flags)
   {
-    instruction::assign_operand(in_operand);
-
-    switch(in_operand[0]) {
-      case '#':
-        addr_mode_ = addressing_mode::immediate;
-        break;
-      case '@':
-        addr_mode_ = addressing_mode::indirect;
-        break;
-      default:
-        addr_mode_ = addressing_mode::simple;
-    }
+    status_t result = instruction::assign_operand(in_operand, in_flags);
+    if (!result.ok())
+      return result;
+
+    if (in_flags & entry_t::f_immediate)
+      addr_mode_ = addressing_mode::immediate;
+    else if (in_flags & entry_t::f_indirect)
+      addr_mode_ = addressing_mode::indirect;
+    else
+      addr_mode_ = addressing_mode::simple;
+
+    encoder_ = encoding::select_fmt4(addr_mode_, indexed_);
+    return result;
   }
 
-  void fmt4_instruction::assemble()
+  status_t fmt4_instruction::assemble()
   {
-    int target_address = 0x0;
-    int disp = 0x0;
-    uint32_t targeting_flags = 0x0;
-
-    if (indexed_)
-      targeting_flags |= 0x8 << 20;
-
     assert(operand_);
 
     // all extended format operations require relocation except constant-operanded ones
     //~ relocatable_ = true;
 
+    if (!encoder_)
+      return status_t::failure(invalid_addressing_mode("indirect addressing mode can not be used in extended format", line()));
+
     // extract the target address
-    operand_->evaluate();
-    disp = target_address = operand_->value();
-
-
-    // assign addressing flags
-    if (addr_mode_ == addressing_mode::immediate)
-    {
-      // if it's an immediate operand
-      //~ if (operand_->is_constant()) {
-        targeting_flags |= 0x1 << 24;
-        //~ relocatable_ = false;
-      //~ }
-    } else if (addr_mode_ == addressing_mode::simple) {
-      targeting_flags |= 0x3 << 24; // neither indirect nor immediate
-      //~ construct_relocation_records();
-
-    } else {
-      throw invalid_addressing_mode("indirect addressing mode can not be used in extended format", this->line_);
-    }
+    status_t result = operand_->evaluate();
+    if (!result.ok())
+      return result;
+
+    int target_address = operand_->value();
 
     if (VERBOSE)
     std::cout
@@ -120,9 +104,12 @@ namespace hax
       << std::hex << std::uppercase
       << target_address << (indexed_ ? "(indexed)" : "") << "\n";
 
-    // discard the 5 highest-order half-bytes (for negative values calculated with 2's complement)
-    objcode_ = (opcode_ << 24) | addr_mode_ | targeting_flags;
-    objcode_ = utility::overwrite_bits<int>(disp, objcode_, 20, 12) | (0x1 << 20);
+    objcode_t objcode = encoder_(opcode_, target_address, location() + length(), parser::singleton().base());
+    if (objcode == encoding::out_of_bounds)
+      return status_t::failure(target_out_of_bounds(utility::to_string(target_address), line()));
+
+    objcode_ = objcode;
+    return result;
   }
 
   bool fmt4_instruction::is_valid() const
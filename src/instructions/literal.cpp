@@ -20,17 +20,19 @@
 
 #include "literal.hpp"
 #include "program_block.hpp"
+#include "operand_classifier.hpp"
+#include "operands/constant.hpp"
 #include <cassert>
-#include <cmath>
 
 namespace hax
 {
   extern bool VERBOSE;
-  using utility::stringify;
 
-	literal::literal(string_t const& in_value, pblock_t* block)
-  : instruction(0x0, in_value, block),
+	literal::literal(std::string_view in_value, pblock_t* block)
+  : instruction(0x0, m_literal, block),
+    value_(in_value),
     is_ascii_(false),
+    bytes_({ 0, 0 }),
     assembled_(false)
   {
     format_ = format::fmt_literal;
@@ -58,33 +60,32 @@ namespace hax
   void literal::copy_from(const literal& src)
   {
     instruction::copy_from(src);
+    value_ = src.value_;
   }
 
-  void literal::preprocess()
+  status_t literal::preprocess()
   {
-    instruction::preprocess();
-
-    is_ascii_ = false;
-    if (mnemonic_.find("=C'") != std::string::npos)
-    {
-      stripped_ = mnemonic_.substr(3, mnemonic_.size()-4);
-      is_ascii_ = true;
-
-    } else if (mnemonic_.find("=X'") != std::string::npos) {
-      stripped_ = mnemonic_.substr(3, mnemonic_.size()-4);
-
-    } else if (mnemonic_.find("X'") != std::string::npos) {
-      stripped_ = mnemonic_.substr(2, mnemonic_.size()-3);
-    }
-
-    length_ = stripped_.size();
-
-    std::cout << "Literal " << this << " original length = " << length_ << "\n";
+    status_t result = instruction::preprocess();
+    if (!result.ok())
+      return result;
+
+    operand_class_t op_class = operand_classifier::classify(value_);
+    is_ascii_ = op_class.kind == operand_class_t::k_ascii_literal
+             || op_class.kind == operand_class_t::k_ascii_constant;
+    stripped_ = op_class.payload(value_);
+    result = constant::decode(stripped_, is_ascii_, string_t(value_), decoded_, bytes_);
+    if (!result.ok())
+      return result;
+
+    length_ = bytes_.length;
+
+    std::cout << "Literal " << this << " original length = " << stripped_.size() << "\n";
+    return result;
+  }
 
-    // since one byte holds 2 hex digits, we divide the length by two
-    if (!is_ascii_) {
-      length_ = std::ceil(length_ / 2);
-    }
+  string_t literal::mnemonic() const
+  {
+    return string_t(value_);
   }
 
   loc_t literal::length() const
@@ -92,28 +93,28 @@ namespace hax
     return length_;
   }
 
-  void literal::assemble()
+  status_t literal::assemble()
   {
     if (assembled_)
-      return;
-
-    std::stringstream hex_repr;
-    hex_repr << std::hex;
-    for (auto c : stripped_)
-      if (is_ascii_)
-        hex_repr << (int)c;
-      else
-        hex_repr << c;
+      return status_t();
 
-    hex_repr >> objcode_;
+    objcode_ = constant::fold(bytes_);
 
     for (auto dep : deps_)
     {
-      dep->evaluate();
+      status_t result = dep->evaluate();
+      if (!result.ok())
+        return result;
     }
     deps_.clear();
 
     assembled_ = true;
+    return status_t();
+  }
+
+  byte_span_t literal::data() const
+  {
+    return bytes_;
   }
 
   void literal::add_dependency(operand* in_operand)
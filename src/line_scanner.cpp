@@ -0,0 +1,363 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "line_scanner.hpp"
+#include <cstring>
+#include <cassert>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+# define HAX_SCANNER_X86 1
+# include <immintrin.h>
+#endif
+
+namespace hax
+{
+  bool scanned_line_t::operator==(scanned_line_t const& rhs) const
+  {
+    if (begin != rhs.begin || end != rhs.end || nr_fields != rhs.nr_fields)
+      return false;
+
+    for (uint32_t i = 0; i < nr_fields && i < max_fields; ++i)
+      if (fields[i].begin != rhs.fields[i].begin || fields[i].end != rhs.fields[i].end)
+        return false;
+
+    return true;
+  }
+
+  namespace {
+
+    /* tracks the line being built while the block is scanned */
+    struct scan_state_t {
+      scanned_line_t line;
+      bool in_field;
+      bool in_comment;
+      bool in_quote;
+
+      inline void reset()
+      {
+        line.nr_fields = 0;
+        in_field = false;
+        in_comment = false;
+        in_quote = false;
+      }
+
+      inline void open_field(size_t pos)
+      {
+        if (line.nr_fields == 0)
+          line.begin = pos;
+        if (line.nr_fields < scanned_line_t::max_fields)
+          line.fields[line.nr_fields].begin = pos;
+        in_field = true;
+      }
+
+      inline void close_field(size_t pos)
+      {
+        if (line.nr_fields < scanned_line_t::max_fields)
+          line.fields[line.nr_fields].end = pos;
+        line.end = pos;
+        ++line.nr_fields;
+        in_field = false;
+      }
+
+      inline void end_line(size_t pos, line_scanner::lines_t& out_lines)
+      {
+        if (in_field)
+          close_field(pos);
+        if (line.nr_fields > 0)
+          out_lines.push_back(line);
+        reset();
+      }
+
+      /* advances the state past the character at pos, this is the whole of
+       * the scalar scanner */
+      inline void step(char c, size_t pos, line_scanner::lines_t& out_lines)
+      {
+        if (c == '\n')
+          end_line(pos, out_lines);
+        else if (in_comment)
+          return;
+        else if (in_quote)
+          in_quote = c != '\'';
+        else if (c == '.' || c == ';')
+        {
+          if (in_field)
+            close_field(pos);
+          in_comment = true;
+        }
+        else if (c == ' ' || c == '\t')
+        {
+          if (in_field)
+            close_field(pos);
+        }
+        else
+        {
+          if (!in_field)
+            open_field(pos);
+          in_quote = c == '\'';
+        }
+      }
+    };
+
+#ifdef HAX_SCANNER_X86
+    /* newline, comment, whitespace and quote positions of a 64-byte chunk */
+    struct masks_t {
+      uint64_t newline;
+      uint64_t comment;
+      uint64_t whitespace;
+      uint64_t quote;
+    };
+
+    inline __attribute__((always_inline))
+    void build_masks_sse2(const char* in_chunk, masks_t& out)
+    {
+      const __m128i newline = _mm_set1_epi8('\n');
+      const __m128i dot     = _mm_set1_epi8('.');
+      const __m128i semi    = _mm_set1_epi8(';');
+      const __m128i space   = _mm_set1_epi8(' ');
+      const __m128i tab     = _mm_set1_epi8('\t');
+      const __m128i quote   = _mm_set1_epi8('\'');
+
+      out.newline = out.comment = out.whitespace = out.quote = 0;
+      for (int i = 0; i < 4; ++i)
+      {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in_chunk + 16 * i));
+        uint64_t nl = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)));
+        uint64_t cm = static_cast<uint16_t>(_mm_movemask_epi8(
+          _mm_or_si128(_mm_cmpeq_epi8(v, dot), _mm_cmpeq_epi8(v, semi))));
+        uint64_t ws = static_cast<uint16_t>(_mm_movemask_epi8(
+          _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab))));
+        uint64_t qt = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)));
+
+        out.newline    |= nl << (16 * i);
+        out.comment    |= cm << (16 * i);
+        out.whitespace |= ws << (16 * i);
+        out.quote      |= qt << (16 * i);
+      }
+    }
+
+    __attribute__((target("avx2"))) inline
+    void build_masks_avx2(const char* in_chunk, masks_t& out)
+    {
+      const __m256i newline = _mm256_set1_epi8('\n');
+      const __m256i dot     = _mm256_set1_epi8('.');
+      const __m256i semi    = _mm256_set1_epi8(';');
+      const __m256i space   = _mm256_set1_epi8(' ');
+      const __m256i tab     = _mm256_set1_epi8('\t');
+      const __m256i quote   = _mm256_set1_epi8('\'');
+
+      out.newline = out.comment = out.whitespace = out.quote = 0;
+      for (int i = 0; i < 2; ++i)
+      {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in_chunk + 32 * i));
+        uint64_t nl = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline)));
+        uint64_t cm = static_cast<uint32_t>(_mm256_movemask_epi8(
+          _mm256_or_si256(_mm256_cmpeq_epi8(v, dot), _mm256_cmpeq_epi8(v, semi))));
+        uint64_t ws = static_cast<uint32_t>(_mm256_movemask_epi8(
+          _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab))));
+        uint64_t qt = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)));
+
+        out.newline    |= nl << (32 * i);
+        out.comment    |= cm << (32 * i);
+        out.whitespace |= ws << (32 * i);
+        out.quote      |= qt << (32 * i);
+      }
+    }
+
+    /* visits the positions of a chunk at which a line, a comment, or a field
+     * begins or ends; in_valid masks out the bytes past the end of the block
+     *
+     * whitespace and comment markers between quotes, as in C'HELLO WORLD',
+     * belong to the field, so the rare chunk that holds a quote or continues
+     * a quoted field is stepped through one character at a time instead */
+    inline __attribute__((always_inline))
+    void scan_chunk(const char* in_chunk, masks_t const& in_masks, uint64_t in_valid,
+                    size_t in_base, uint64_t& io_carry, scan_state_t& io_state,
+                    line_scanner::lines_t& out_lines)
+    {
+      uint64_t field_chars = ~(in_masks.whitespace | in_masks.newline) & in_valid;
+      uint64_t shifted = (field_chars << 1) | io_carry;
+      uint64_t starts = field_chars & ~shifted;
+      uint64_t ends = ~field_chars & shifted & in_valid;
+      io_carry = field_chars >> 63;
+
+      if ((in_masks.quote & in_valid) || io_state.in_quote)
+      {
+        for (size_t i = 0; i < 64 && (in_valid >> i) & 1; ++i)
+          io_state.step(in_chunk[i], in_base + i, out_lines);
+        return;
+      }
+
+      uint64_t events = ((in_masks.newline | in_masks.comment) & in_valid) | starts | ends;
+      while (events)
+      {
+        uint64_t bit = events & (~events + 1);
+        size_t pos = in_base + __builtin_ctzll(events);
+        events ^= bit;
+
+        if (in_masks.newline & bit)
+          io_state.end_line(pos, out_lines);
+        else if (io_state.in_comment)
+          continue;
+        else if (in_masks.comment & bit)
+        {
+          if (io_state.in_field)
+            io_state.close_field(pos);
+          io_state.in_comment = true;
+        }
+        else if (starts & bit)
+          io_state.open_field(pos);
+        else if (io_state.in_field)
+          io_state.close_field(pos);
+      }
+    }
+
+    template <void (*build_masks)(const char*, masks_t&)>
+    inline __attribute__((always_inline))
+    void scan_blocks(const char* in_data, size_t in_size, line_scanner::lines_t& out_lines)
+    {
+      scan_state_t state;
+      state.reset();
+
+      masks_t masks;
+      uint64_t carry = 0;
+      size_t base = 0;
+      for (; base + 64 <= in_size; base += 64)
+      {
+        build_masks(in_data + base, masks);
+        scan_chunk(in_data + base, masks, ~uint64_t(0), base, carry, state, out_lines);
+      }
+
+      // the tail is copied into a chunk padded with whitespace so no bytes
+      // past the end of the block are read
+      if (base < in_size)
+      {
+        char tail[64];
+        size_t remaining = in_size - base;
+        std::memset(tail, ' ', sizeof(tail));
+        std::memcpy(tail, in_data + base, remaining);
+
+        build_masks(tail, masks);
+        scan_chunk(tail, masks, (uint64_t(1) << remaining) - 1, base, carry, state, out_lines);
+      }
+
+      state.end_line(in_size, out_lines);
+    }
+
+    __attribute__((target("avx2")))
+    void scan_blocks_avx2(const char* in_data, size_t in_size, line_scanner::lines_t& out_lines)
+    {
+      scan_blocks<build_masks_avx2>(in_data, in_size, out_lines);
+    }
+#endif
+
+    typedef void (*scan_fn_t)(const char*, size_t, line_scanner::lines_t&);
+
+    scan_fn_t select_scanner(const char** out_isa)
+    {
+      if (line_scanner::has_avx2()) {
+        *out_isa = "AVX2";
+        return &line_scanner::scan_avx2;
+      } else if (line_scanner::has_sse2()) {
+        *out_isa = "SSE2";
+        return &line_scanner::scan_sse2;
+      }
+
+      *out_isa = "scalar";
+      return &line_scanner::scan_scalar;
+    }
+
+    const char* selected_isa = 0;
+    scan_fn_t selected_scanner = select_scanner(&selected_isa);
+  }
+
+  void line_scanner::scan(const char* in_data, size_t in_size, lines_t& out_lines)
+  {
+#ifndef NDEBUG
+    size_t first = out_lines.size();
+#endif
+
+    selected_scanner(in_data, in_size, out_lines);
+
+#ifndef NDEBUG
+    // the vectorized scanners must agree with the scalar one
+    if (selected_scanner != &line_scanner::scan_scalar)
+    {
+      lines_t reference;
+      scan_scalar(in_data, in_size, reference);
+      assert(reference.size() == out_lines.size() - first);
+      for (size_t i = 0; i < reference.size(); ++i)
+        assert(reference[i] == out_lines[first + i]);
+    }
+#endif
+  }
+
+  void line_scanner::scan_scalar(const char* in_data, size_t in_size, lines_t& out_lines)
+  {
+    scan_state_t state;
+    state.reset();
+
+    for (size_t i = 0; i < in_size; ++i)
+      state.step(in_data[i], i, out_lines);
+
+    state.end_line(in_size, out_lines);
+  }
+
+  void line_scanner::scan_sse2(const char* in_data, size_t in_size, lines_t& out_lines)
+  {
+#ifdef HAX_SCANNER_X86
+    scan_blocks<build_masks_sse2>(in_data, in_size, out_lines);
+#else
+    scan_scalar(in_data, in_size, out_lines);
+#endif
+  }
+
+  void line_scanner::scan_avx2(const char* in_data, size_t in_size, lines_t& out_lines)
+  {
+#ifdef HAX_SCANNER_X86
+    if (has_avx2())
+      return scan_blocks_avx2(in_data, in_size, out_lines);
+#endif
+    scan_sse2(in_data, in_size, out_lines);
+  }
+
+  bool line_scanner::has_sse2()
+  {
+#ifdef HAX_SCANNER_X86
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  bool line_scanner::has_avx2()
+  {
+#ifdef HAX_SCANNER_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+  }
+
+  const char* line_scanner::isa()
+  {
+    return selected_isa;
+  }
+} // end of namespace
@@ -24,10 +24,12 @@
 #include "hax.hpp"
 #include "parser.hpp"
 #include "hax_utility.hpp"
+#include "hax_stats.hpp"
 
 namespace hax {
   bool VERBOSE = false;
   bool DELIMITED_OUTPUT = false;
+  bool PRINT_STATS = false;
 }
 
 using hax::string_t;
@@ -35,6 +37,7 @@ using hax::string_t;
 void print_usage()
 {
   std::cout << "Usage: hasm [OPTIONS] input_file\n";
+  std::cout << "Pass - as input_file to read the program from the standard input\n";
   std::cout << "Re-run with --help for a list of supported arguments\n";
 }
 
@@ -46,9 +49,11 @@ void print_help()
   std::cout
     << "Hax Assembler: translates SIC/XE compatible assembly listings "
     << "into loadable object programs.\n";
+  std::cout << "Pass - as input_file to read the program from the standard input.\n";
 
   commands_.insert(std::make_pair("-o FILE", "write object program into FILE (default: ./a.obj)"));
   commands_.insert(std::make_pair("-v", "runs in verbose mode (default: off)"));
+  commands_.insert(std::make_pair("-s", "prints allocation statistics on exit (default: off)"));
   commands_.insert(std::make_pair("-d", "object program fields in output will be delimited \n\
   \t\t\tby '^' to be more human-readable (default: off)"));
 
@@ -80,13 +85,15 @@ int main(int argc, char** argv)
   // destination of object program
   std::string _out = "a.obj";
 
-  // parse arguments
-  for (int i=1; i < argc; ++i)
+  // parse arguments, the last one is the input file
+  for (int i=1; i < argc-1; ++i)
   {
     if (std::string(argv[i]) == "-v")
       hax::VERBOSE = true;
     else if (std::string(argv[i]) == "-d")
       hax::DELIMITED_OUTPUT = true;
+    else if (std::string(argv[i]) == "-s")
+      hax::PRINT_STATS = true;
     else if (std::string(argv[i]) == "-o")
     {
       // make sure a path was specified
@@ -111,7 +118,7 @@ int main(int argc, char** argv)
   }
 
   std::cout << "+- Hax Assembler engaged -+\n";
-  std::cout << "+-\tInput: " << _in << '\n';
+  std::cout << "+-\tInput: " << (_in == "-" ? "<stdin>" : _in) << '\n';
   std::cout << "+-\tOutput: " << _out << '\n';
   std::cout << "+-\tRerun with --help for list of supported arguments\n";
 
@@ -125,5 +132,8 @@ int main(int argc, char** argv)
     return 1;
   }*/
 
+  if (hax::PRINT_STATS)
+    hax::stats::dump(std::cout);
+
   return 1;
 }
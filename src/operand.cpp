@@ -23,9 +23,7 @@
 
 namespace hax
 {
-  using utility::stringify;
-
-	operand::operand(string_t const& in_token, instruction* in_inst)
+	operand::operand(std::string_view in_token, instruction* in_inst)
   : token_(in_token),
     value_(0x0),
     type_(t_undefined),
@@ -73,7 +71,7 @@ namespace hax
     return in;
   }
 
-  string_t const& operand::token() const
+  std::string_view operand::token() const
   {
     return token_;
   }
@@ -113,7 +111,7 @@ namespace hax
     return type_ == t_literal;
   }
 
-  uint16_t operand::length() const
+  loc_t operand::length() const
   {
     return length_;
   }
@@ -0,0 +1,130 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "operand_classifier.hpp"
+
+namespace hax
+{
+  namespace {
+    enum char_class_t : uint8_t {
+      c_digit     = 0x01,
+      c_operator  = 0x02,
+      c_other     = 0x04
+    };
+
+    struct char_table_t {
+      uint8_t classes[256];
+
+      constexpr char_table_t() : classes()
+      {
+        for (int c = 0; c < 256; ++c)
+          classes[c] = c_other;
+
+        for (int c = '0'; c <= '9'; ++c)
+          classes[c] = c_digit;
+
+        // keep in sync with utility::is_operator()
+        const char operators[] = "()+-*/%^";
+        for (int i = 0; operators[i]; ++i)
+          classes[static_cast<uint8_t>(operators[i])] = c_operator;
+      }
+    };
+
+    constexpr char_table_t char_table;
+
+    inline uint8_t class_of(char c)
+    {
+      return char_table.classes[static_cast<uint8_t>(c)];
+    }
+
+    /* the end of the payload of a quoted token, which excludes the closing quote */
+    inline size_t quoted_end(std::string_view in_token, size_t in_begin)
+    {
+      size_t end = in_token.size();
+      return (end > in_begin && in_token[end-1] == '\'') ? end-1 : end;
+    }
+  }
+
+  operand_class_t operand_classifier::classify(std::string_view in_token)
+  {
+    operand_class_t out;
+    out.prefix = (!in_token.empty() && (in_token[0] == '#' || in_token[0] == '@')) ? 1 : 0;
+    out.payload_begin = out.prefix;
+    out.payload_end = in_token.size();
+
+    const size_t size = in_token.size();
+    size_t i = out.prefix;
+
+    // the quoted forms are recognized by their first few characters alone
+    if (i + 1 < size)
+    {
+      bool is_literal = in_token[i] == '=';
+      size_t quote = i + 1 + (is_literal ? 1 : 0);
+      if (quote < size && in_token[quote] == '\'')
+      {
+        char fmt = in_token[quote-1];
+        if (fmt == 'C' || fmt == 'X')
+        {
+          if (is_literal)
+            out.kind = fmt == 'C' ? operand_class_t::k_ascii_literal : operand_class_t::k_hex_literal;
+          else
+            out.kind = fmt == 'C' ? operand_class_t::k_ascii_constant : operand_class_t::k_hex_constant;
+
+          out.payload_begin = quote + 1;
+          out.payload_end = quoted_end(in_token, out.payload_begin);
+          return out;
+        }
+      }
+    }
+
+    if (i < size && in_token[i] == '*')
+    {
+      out.kind = operand_class_t::k_current_loc;
+      out.payload_end = i + 1;
+      return out;
+    }
+
+    uint8_t seen = 0;
+    for (; i < size; ++i)
+    {
+      seen |= class_of(in_token[i]);
+
+      // operators are only allowed within expressions
+      if (seen & c_operator)
+      {
+        out.kind = operand_class_t::k_expression;
+        return out;
+      }
+    }
+
+    // tokens made up only of digits are decimals, so is an empty one
+    out.kind = (seen & c_other) ? operand_class_t::k_symbol : operand_class_t::k_decimal;
+    return out;
+  }
+
+  bool operand_classifier::is_symbol(std::string_view in_token)
+  {
+    // symbols can not begin with a number
+    if (in_token.empty() || class_of(in_token[0]) == c_digit)
+      return false;
+
+    return classify(in_token).kind == operand_class_t::k_symbol;
+  }
+} // end of namespace
@@ -19,8 +19,10 @@
  */
 
 #include "operand_factory.hpp"
+#include "operand_classifier.hpp"
 #include "symbol_manager.hpp"
 #include "parser.hpp"
+#include "control_section.hpp"
 
 namespace hax
 {
@@ -45,78 +47,36 @@ namespace hax
 		return *singleton_ptr();
 	}
 
-  operand_t*
-  operand_factory::create(string_t const& in_token, instruction* in_inst)
+  status_t
+  operand_factory::create(std::string_view in_token, instruction* in_inst, operand_t*& out_operand)
   {
-
-    string_t operand_str(in_token);
-
     // find out what kind of operand it is, there are three options:
     //  1. a constant, which could be an ASCII or HEX literal, or a decimal number
     //  2. a symbol
     //  3. expression
-
-    operand* _operand = 0;
-    // strip out any leading addressing mode flags (@ or #)
-    if (operand_str[0] == '@' || operand_str[0] == '#')
-      operand_str = operand_str.substr(1, operand_str.size()-1);
-
-    // a constant
-    if (__is_constant(operand_str)) {
-      _operand = new constant(in_token, in_inst);
-    } else if (__is_expression(operand_str)) {
-      _operand = new expression(in_token, in_inst);
+    operand_class_t op_class = operand_classifier::classify(in_token);
+
+    control_section* sect = in_inst->block()->sect();
+
+    if (constant_pool::is_poolable(op_class)) {
+      // constants that do not depend on where they are used are shared
+      constant_t* _constant = 0;
+      status_t result = sect->constants().acquire(in_token, op_class, in_inst->line(), _constant);
+      out_operand = _constant;
+      return result;
+    } else if (op_class.is_constant()) {
+      out_operand = sect->arena().create<constant>(in_token, in_inst, op_class);
+    } else if (op_class.kind == operand_class_t::k_expression) {
+      // so are expressions, which are compiled and evaluated once
+      expression_t* _expr = 0;
+      status_t result = sect->expressions().acquire(in_token, op_class, in_inst, _expr);
+      out_operand = _expr;
+      return result;
     } else {
-      // we do not own symbol objects, so we grab a reference
-      // if the symbol is not already defined, then in_inst is the owner of this symbol
-      symbol_manager *symmgr = parser::singleton().sect()->symmgr();
-      _operand = symmgr->declare(operand_str);
+      // symbols are shared by every instruction that refers to them, so we
+      // grab the one the symbol manager keeps
+      out_operand = sect->symmgr()->declare(op_class.payload(in_token));
     }
-    return _operand;
-  }
-
-  bool operand_factory::__is_constant(string_t const& token)
-  {
-    return token.find("C'") < 2
-        || token.find("X'") < 2
-        || token[0] == '*'
-        || utility::is_decimal_nr(token);
-  }
-
-  bool operand_factory::__is_literal(string_t const& token)
-  {
-    return token.find("=C'") == 0
-        || token.find("=X'") == 0;
-  }
-
-  bool operand_factory::__is_symbol(string_t const& token)
-  {
-    if (token.empty())
-      return false;
-
-    // symbols can not begin with a number and must not contain any operator chars
-    char c = token[0];
-    if((c >= '0' && c <= '9') ||
-      token.find('-') != std::string::npos ||
-      token.find('+') != std::string::npos ||
-      token.find('/') != std::string::npos ||
-      token.find('*') != std::string::npos ||
-      token.find('(') != std::string::npos ||
-      token.find(')') != std::string::npos)
-      return false;
-
-    return true;
-  }
-
-  bool operand_factory::__is_expression(string_t const& token)
-  {
-    // although we can use C++ TR1 regex here for a more robust solution,
-    // for simplicity, I choose to stupidly scan the token for any operators
-    // as they are only allowed within expressions
-    for (auto c : token)
-      if (utility::is_operator(c))
-        return true;
-
-    return false;
+    return status_t();
   }
 } // end of namespace
@@ -19,53 +19,44 @@
  */
 
 #include "operands/constant.hpp"
+#include "hex_decoder.hpp"
 #include "parser.hpp"
-#include <cmath>
 
 namespace hax
 {
-  using utility::stringify;
-
-	constant::constant(string_t const& in_token, instruction* in_inst)
-  : operand(in_token, in_inst)
+	constant::constant(std::string_view in_token, instruction* in_inst, operand_class_t const& in_class)
+  : operand(in_token, in_inst),
+    bytes_({ 0, 0 }),
+    shared_(false)
   {
     type_ = t_constant;
 
-    // ASCII literals, format: =C'characters'
-    if (in_token.find("=C'") != std::string::npos)
+    switch (in_class.kind)
     {
-      handler_ = &constant::handle_literal;
-      type_ = t_literal;
-    }
-    // Hexadecimal literals, format: =X'digits'
-    else if (in_token.find("=X'") != std::string::npos) {
-      handler_ = &constant::handle_literal;
-      type_ = t_literal;
-    }
-
-    // Hexadecimal constants, format: X'hexdigits'
-    else if (in_token.find("X'") != std::string::npos) {
-      handler_ = &constant::handle_hex_constant;
-      stripped_ = token_.substr(2, token_.size()-3);
-
-    }
-    // ASCII constants, format: C'characters'
-    else if (in_token.find("C'") != std::string::npos) {
-      handler_ = &constant::handle_ascii_constant;
-      stripped_ = token_.substr(2, token_.size()-3);
-
-    }
-    // Special operator *, denotes the current value of the location counter
-    else if (in_token[0] == '*') {
-      handler_ = &constant::handle_current_loc;
-    }
-    // Decimal constant
-    else {
-
-      if (token_[0] == '#')
-        token_ = token_.substr(1, token_.size()-1);
-
-      handler_ = &constant::handle_constant;
+      // literals, format: =C'characters' or =X'digits'
+      case operand_class_t::k_ascii_literal:
+      case operand_class_t::k_hex_literal:
+        handler_ = &constant::handle_literal;
+        type_ = t_literal;
+      break;
+      // Hexadecimal constants, format: X'hexdigits'
+      case operand_class_t::k_hex_constant:
+        handler_ = &constant::handle_hex_constant;
+        stripped_ = in_class.payload(in_token);
+      break;
+      // ASCII constants, format: C'characters'
+      case operand_class_t::k_ascii_constant:
+        handler_ = &constant::handle_ascii_constant;
+        stripped_ = in_class.payload(in_token);
+      break;
+      // Special operator *, denotes the current value of the location counter
+      case operand_class_t::k_current_loc:
+        handler_ = &constant::handle_current_loc;
+      break;
+      // Decimal constant
+      default:
+        token_ = in_class.payload(in_token);
+        handler_ = &constant::handle_constant;
     }
 
     // if the operand is a literal, declare the dependency
@@ -80,7 +71,7 @@ namespace hax
     handler_ = 0;
 	}
 
-  constant::constant(const constant& src) : operand(src.token_, src.inst_)
+  constant::constant(const constant& src) : operand(src.token_, src.inst_), bytes_({ 0, 0 }), shared_(false)
   {
     copy_from(src);
   }
@@ -97,57 +88,108 @@ namespace hax
   {
   }
 
-  void constant::evaluate()
+  status_t constant::evaluate()
+  {
+    if (shared_)
+      return status_t();
+
+    status_t result = (this->*handler_)();
+    if (result.ok())
+      evaluated_ = true;
+
+    return result;
+  }
+
+  status_t constant::__share()
+  {
+    status_t result = evaluate();
+    shared_ = result.ok();
+    return result;
+  }
+
+  bool constant::is_shared() const
+  {
+    return shared_;
+  }
+
+  byte_span_t constant::bytes() const
+  {
+    return bytes_;
+  }
+
+  status_t constant::decode(std::string_view in_payload,
+                            bool in_ascii,
+                            string_t const& in_line,
+                            std::vector<uint8_t>& out_decoded,
+                            byte_span_t& out_bytes)
+  {
+    if (in_ascii)
+    {
+      out_bytes = { reinterpret_cast<const uint8_t*>(in_payload.data()), uint32_t(in_payload.size()) };
+      return status_t();
+    }
+
+    if (!hex_decoder::decode(in_payload, out_decoded))
+      return status_t::failure(invalid_operand("'" + string_t(in_payload) + "' is not a hexadecimal number", in_line));
+
+    out_bytes = { out_decoded.data(), uint32_t(out_decoded.size()) };
+    return status_t();
+  }
+
+  objcode_t constant::fold(byte_span_t in_bytes)
   {
-    (this->*handler_)();
-    evaluated_ = true;
+    objcode_t word = 0;
+    uint32_t i = in_bytes.length > 4 ? in_bytes.length - 4 : 0;
+    for (; i < in_bytes.length; ++i)
+      word = (word << 8) | in_bytes.data[i];
+
+    return word;
   }
 
-  void constant::handle_literal()
+  status_t constant::handle_literal()
   {
     instruction* lit = inst_->block()->sect()->symmgr()->lookup_literal(token_);
     value_ = lit->location();
+    return status_t();
   }
 
-  void constant::handle_constant()
+  status_t constant::handle_constant()
   {
-    value_ = utility::convertTo<int>(token_);
+    int value;
+    if (!utility::parse_number(token_, value, 10))
+      return status_t::failure(bad_conversion(string_t(token_)));
+
+    value_ = value;
     length_ = token_.size();
+    return status_t();
   }
 
-  void constant::handle_ascii_constant()
+  status_t constant::handle_ascii_constant()
   {
-    handle_hex_or_ascii_constant(true);
+    return handle_hex_or_ascii_constant(true);
   }
 
-  void constant::handle_hex_constant()
+  status_t constant::handle_hex_constant()
   {
-    handle_hex_or_ascii_constant(false);
+    return handle_hex_or_ascii_constant(false);
   }
 
-  void constant::handle_hex_or_ascii_constant(bool is_ascii)
+  status_t constant::handle_hex_or_ascii_constant(bool is_ascii)
   {
-    std::stringstream hex_repr;
-    hex_repr << std::hex;
-    for (auto c : stripped_)
-      if (is_ascii)
-        hex_repr << (int)c;
-      else
-        hex_repr << c;
-
-    hex_repr >> value_;
-
-    length_ = stripped_.size();
+    status_t result = decode(stripped_, is_ascii, inst_ ? inst_->line() : string_t(token_), decoded_, bytes_);
+    if (!result.ok())
+      return result;
 
-    // since one byte holds 2 hex digits, we divide the length by two
-    if (!is_ascii)
-      length_ = std::ceil(length_ / 2);
+    value_ = fold(bytes_);
+    length_ = bytes_.length;
+    return result;
   }
 
-  void constant::handle_current_loc()
+  status_t constant::handle_current_loc()
   {
     value_ = inst_->block()->locctr();
     length_ = 0;
     //~ std::cout << "assigned location counter " << value_ << "\n";
+    return status_t();
   }
 } // end of namespace
@@ -19,56 +19,246 @@
  */
 
 #include "operands/expression.hpp"
-#include "operand_factory.hpp"
+#include "operand_classifier.hpp"
 #include "symbol_manager.hpp"
 #include "parser.hpp"
+#include "hax_stats.hpp"
+#include <algorithm>
 
 namespace hax
 {
-  using utility::stringify;
-  using utility::is_operator;
+  /**
+   * compiles an infix expression into the postfix program of an expression
+   * by recursive descent:
+   *
+   *  sum     := product (('+' | '-') product)*
+   *  product := unary (('*' | '/' | '%') unary)*
+   *  unary   := ('-' | '+') unary | primary
+   *  primary := '(' sum ')' | term
+   *
+   * an operation whose operands are literal numbers is folded into a number
+   * as soon as it is emitted, operations on symbols are left to evaluate()
+   *
+   * the first error found is kept and everything past it is skipped, so it is
+   * reported without unwinding the descent
+   **/
+  class expression_compiler {
+    public:
+
+    expression_compiler(expression& in_expr)
+    : expr_(in_expr),
+      in_(in_expr.token_),
+      pos_(0),
+      depth_(0),
+      nesting_(0)
+    {
+    }
 
-  expression::weights_t expression::operator_weights;
+    status_t compile()
+    {
+      sum();
 
-	expression::expression(string_t const& in_token, instruction* in_inst)
-  : operand(in_token, in_inst)
-  {
-    type_ = t_expression;
+      skip_spaces();
+      if (!failed() && pos_ < in_.size())
+      {
+        if (in_[pos_] == ')')
+          fail("no equivalent '(' for ')'", pos_);
+        else
+          fail(string_t("unexpected '") + in_[pos_] + "'", pos_);
+      }
+
+      return std::move(status_);
+    }
+
+    protected:
+    expression& expr_;
+    std::string_view in_;
+    size_t pos_;
+    size_t depth_;
+    size_t nesting_;
+    status_t status_;
+
+    bool failed() const
+    {
+      return !status_.ok();
+    }
+
+    void fail(string_t const& in_msg, size_t in_position)
+    {
+      if (!failed())
+        status_ = expr_.__fail(in_msg, in_position);
+    }
+
+    void skip_spaces()
+    {
+      while (pos_ < in_.size() && (in_[pos_] == ' ' || in_[pos_] == '\t'))
+        ++pos_;
+    }
+
+    /* the next character, or 0 at the end of the token */
+    char peek()
+    {
+      skip_spaces();
+      return pos_ < in_.size() ? in_[pos_] : 0;
+    }
+
+    void emit(expression::op_t::code_t in_code, size_t in_position, uint32_t in_arg = 0)
+    {
+      if (failed())
+        return;
+
+      switch (in_code)
+      {
+        case expression::op_t::o_number:
+        case expression::op_t::o_symbol:
+          if (++depth_ > expression::max_depth)
+            return fail("expression is too deeply nested", in_position);
+          break;
+        case expression::op_t::o_negate:
+          break;
+        default:
+          --depth_;
+      }
+
+      uint16_t position = uint16_t(std::min<size_t>(in_position, 0xFFFF));
+      expression::program_t& program = expr_.program_;
+      size_t count = program.size();
+
+      if (in_code == expression::op_t::o_negate)
+      {
+        if (count && program.back().code == expression::op_t::o_number)
+        {
+          program.back().arg = uint32_t(expression::apply(in_code, 0, int32_t(program.back().arg)));
+          ++stats::folded_operations;
+          return;
+        }
+      }
+      else if (in_code != expression::op_t::o_number && in_code != expression::op_t::o_symbol &&
+               count >= 2 &&
+               program[count-1].code == expression::op_t::o_number &&
+               program[count-2].code == expression::op_t::o_number)
+      {
+        int32_t rhs = int32_t(program[count-1].arg);
+        if (rhs == 0 && (in_code == expression::op_t::o_divide || in_code == expression::op_t::o_modulo))
+          return fail("division by zero", in_position);
+
+        program.pop_back();
+        program.back().arg = uint32_t(expression::apply(in_code, int32_t(program.back().arg), rhs));
+        ++stats::folded_operations;
+        return;
+      }
+
+      program.push_back({ in_code, position, in_arg });
+    }
+
+    void sum()
+    {
+      product();
+      for (char c = peek(); !failed() && (c == '+' || c == '-'); c = peek())
+      {
+        size_t at = pos_++;
+        product();
+        emit(c == '+' ? expression::op_t::o_add : expression::op_t::o_subtract, at);
+      }
+    }
 
-    if (operator_weights.empty())
+    void product()
     {
-      operator_weights.insert(std::make_pair('(', 2));
-      operator_weights.insert(std::make_pair(')', 2));
-      operator_weights.insert(std::make_pair('*', 0));
-      operator_weights.insert(std::make_pair('/', 0));
-      operator_weights.insert(std::make_pair('%', 0));
-      operator_weights.insert(std::make_pair('+', 1));
-      operator_weights.insert(std::make_pair('-', 1));
+      unary();
+      for (char c = peek(); !failed() && (c == '*' || c == '/' || c == '%'); c = peek())
+      {
+        size_t at = pos_++;
+        unary();
+        emit(c == '*' ? expression::op_t::o_multiply
+           : c == '/' ? expression::op_t::o_divide
+           : expression::op_t::o_modulo, at);
+      }
     }
 
-    to_postfix(token_, postfix_expr_);
+    void unary()
+    {
+      char c = peek();
+      if (c != '-' && c != '+')
+        return primary();
+
+      size_t at = pos_++;
+      if (++nesting_ > expression::max_depth)
+        return fail("expression is too deeply nested", at);
+
+      unary();
+      --nesting_;
 
-    // populate the list of (un)resolved symbols referenced in this expression
-    operand_factory& op_fact = operand_factory::singleton();
-    std::vector<string_t> tokens = utility::split(postfix_expr_, ' ');
-    for (auto token : tokens)
+      if (c == '-')
+        emit(expression::op_t::o_negate, at);
+    }
+
+    void primary()
     {
-      //~ std::cout << "\tchecking whether " << token << " is a symbol\n";
-      if (op_fact.__is_symbol(token))
+      char c = peek();
+      size_t at = pos_;
+      if (c == '(')
+      {
+        if (++nesting_ > expression::max_depth)
+          return fail("expression is too deeply nested", at);
+
+        ++pos_;
+        sum();
+        if (failed())
+          return;
+
+        if (peek() != ')')
+          return fail("no equivalent ')' for '('", at);
+
+        ++pos_;
+        --nesting_;
+        return;
+      }
+
+      // a term runs up to the next operator
+      while (pos_ < in_.size() && !utility::is_operator(in_[pos_]) && in_[pos_] != ' ' && in_[pos_] != '\t')
+        ++pos_;
+
+      std::string_view term = in_.substr(at, pos_ - at);
+      if (term.empty())
+        return fail(c ? string_t("expected a term but found '") + c + "'" : "expected a term", at);
+
+      if (utility::is_decimal_nr(term))
+      {
+        uint32_t number;
+        if (!utility::parse_number(term, number, 10))
+          return fail("'" + string_t(term) + "' does not fit in a word", at);
+
+        emit(expression::op_t::o_number, at, number);
+      }
+      else if (operand_classifier::is_symbol(term))
       {
-        symbol_manager* symmgr = inst_->block()->sect()->symmgr();
-        extrefs_.push_back(symmgr->declare(token));
+        symbol_t* sym = expr_.symbols_->declare(term);
+        expr_.extrefs_.push_back(sym);
+        emit(expression::op_t::o_symbol, at, sym->id());
       }
+      else
+        fail("'" + string_t(term) + "' is neither a symbol nor a decimal number", at);
     }
+  };
 
-    //~ std::cout << "\texpression contains " << extrefs_.size() << " forward references to symbols\n";
+	expression::expression(std::string_view in_token, instruction* in_inst)
+  : operand(in_token, in_inst),
+    symbols_(in_inst->block()->sect()->symmgr()),
+    epoch_(0),
+    shared_(false)
+  {
+    type_ = t_expression;
 	}
 
 	expression::~expression()
 	{
 	}
 
-  expression::expression(const expression& src) : operand(src.token_, src.inst_)
+  expression::expression(const expression& src)
+  : operand(src.token_, src.inst_),
+    symbols_(src.symbols_),
+    epoch_(0),
+    shared_(false)
   {
     copy_from(src);
   }
@@ -83,215 +273,191 @@ namespace hax
 
   void expression::copy_from(const expression& src)
   {
+    program_ = src.program_;
+    extrefs_ = src.extrefs_;
+    symbols_ = src.symbols_;
   }
 
-  void expression::evaluate()
+  status_t expression::compile()
   {
-    if (evaluated_) {
-      assert(false); // this REALLY should not happen
-      return;
-    }
-
-    // only when all external symbol references are resolved can we evaluate
-    if (!extrefs_.empty())
-    {
-      for (auto sym : extrefs_)
-      {
-        if (!sym->is_evaluated())
-        {
-          //~ std::cout << "\t" << sym << " is still not resolved, can not evaluate\n";
-          throw unevaluated_operand(sym->token() + " is still not resolved, can not evaluate expression");
-          return;
-        }
-      }
-
-      // now substitute every term in the expression with the symbol's value
-      std::vector<string_t> tokens = utility::split(postfix_expr_, ' ');
-      for (string_t& token : tokens)
-      {
-         if (operand_factory::singleton().__is_symbol(token))
-         {
-           // find the symbol
-           bool substituted = false;
-           for (auto sym : extrefs_)
-           {
-             if (sym->token() == token) {
-              //~ std::cout << "\tsubstituted external ref term: " << token << " with " << sym->value() << "\n";
-              token = stringify(sym->value());
-              substituted = true;
-            }
-           }
-
-           if (!substituted)
-            throw invalid_expression("unable to evaluate symbol in expression: " + token, (inst_ ? inst_->line() : token_));
-         }
-      }
-
-      //~ std::cout << "\tPostfix expression was: " << postfix_expr_ << "\n";
-      postfix_expr_ = utility::join(tokens, ' ');
-      //~ std::cout << "\tPostfix expression now substituted: " << postfix_expr_ << "\n";
+    return expression_compiler(*this).compile();
+  }
 
-      // don't clear the references since we need them for the M records
-      //~ extrefs_.clear();
-    }
+  status_t expression::__fail(string_t const& in_msg, size_t in_position) const
+  {
+    return status_t::failure(invalid_expression(
+      in_msg + " at position " + utility::to_string(in_position + 1) + " of '" + string_t(token_) + "'",
+      inst_ ? inst_->line() : string_t(token_)));
+  }
 
-    //~ std::cout << "\tall expression symbol references are now resolved, evaluating...\n";
-    value_ = evaluate_postfix(postfix_expr_);
-    length_ = 3;
-    evaluated_ = true;
+  void expression::__share()
+  {
+    inst_ = 0;
+    shared_ = true;
   }
 
-  bool expression::has_precedence(char op1, char op2)
+  bool expression::is_shared() const
   {
-    assert(is_operator(op1) && is_operator(op2));
-    return operator_weights[op1] <= operator_weights[op2];
+    return shared_;
   }
 
+  int32_t expression::apply(op_t::code_t in_code, int32_t in_lhs, int32_t in_rhs)
+  {
+    // none of the operations can overflow 64 bits
+    int64_t lhs = in_lhs, rhs = in_rhs;
+    switch (in_code)
+    {
+      case op_t::o_negate:
+        return int32_t(-rhs);
+      case op_t::o_add:
+        return int32_t(lhs + rhs);
+      case op_t::o_subtract:
+        return int32_t(lhs - rhs);
+      case op_t::o_multiply:
+        return int32_t(lhs * rhs);
+      case op_t::o_divide:
+        return int32_t(lhs / rhs);
+      case op_t::o_modulo:
+        return int32_t(lhs % rhs);
+      default:
+        assert(false);
+        return 0;
+    }
+  }
 
-  void expression::to_postfix(string_t const& in, string_t &out)
+  status_t expression::evaluate()
   {
+    if (evaluated_ && epoch_ == symbols_->epoch())
+    {
+      ++stats::saved_evaluations;
+      return status_t();
+    }
 
-    std::vector<char> operators;
-    std::vector<std::string> operands;
+    int32_t stack[max_depth];
+    size_t top = 0;
 
-    string_t operand = "";
-    string_t _in = utility::remove_in_string(in, ' ');
-    for (char c : _in)
+    for (op_t const& op : program_)
     {
-      //~ std::cout << "checking " << c << " in " << in << "\n";
-      if (!is_operator(c))
-      {
-        operand.push_back(c);
-        continue;
-      }
-      if (!operand.empty()) {
-        operands.push_back(operand);
-        out += operand + " ";
-        operand = "";
-      }
-
-      // handle operators
-      if (operators.empty())
+      switch (op.code)
       {
-        if (c == ')')
-          throw hax::invalid_expression("no equivalent '(' for ')'", (inst_ ? inst_->line() : token_));
-
-        operators.push_back(c);
-        continue;
-      }
+        case op_t::o_number:
+          stack[top++] = int32_t(op.arg);
+          break;
 
-      if (c == ')')
-      {
-        while (!operators.empty() && operators.back() != '(')
+        case op_t::o_symbol:
         {
-          out.push_back(operators.back());
-          out.push_back(' ');
-          operators.pop_back();
+          symbol_t const* sym = symbols_->lookup(symbol_id_t(op.arg));
+          if (!sym || !sym->is_evaluated())
+            return status_t::failure(unevaluated_operand(string_t(symbols_->name(op.arg)) + " is still not resolved, can not evaluate expression"));
+
+          stack[top++] = int32_t(sym->value());
+          break;
         }
 
-        // remove the left paranthesis
-        assert(!operators.empty());
-        operators.pop_back();
+        case op_t::o_negate:
+          stack[top-1] = apply(op.code, 0, stack[top-1]);
+          break;
 
-        continue;
-      } else if (c == '(')
-      {
-        operators.push_back(c);
-        continue;
-      }
+        default:
+          if (stack[top-1] == 0 && (op.code == op_t::o_divide || op.code == op_t::o_modulo))
+            return __fail("division by zero", op.position);
 
-      // pop any operators in the stack with higher priority than this one, add
-      // them to the postfix string, and finally push this operator onto the stack
-      while (!operators.empty() && has_precedence(operators.back(), c))
-      {
-        out.push_back(operators.back());
-        out.push_back(' ');
-        operators.pop_back();
+          stack[top-2] = apply(op.code, stack[top-2], stack[top-1]);
+          --top;
       }
-      operators.push_back(c);
-    }
-
-    if (!operand.empty()) {
-      out += operand + " ";
-      operands.push_back(operand);
     }
 
-    while (!operators.empty())
-    {
-      out.push_back(operators.back());
-      out.push_back(' ');
-      operators.pop_back();
-    }
+    assert(top == 1);
 
-    //~ std::cout << "evaluating " << (absolute_ ? "constant" : "relative") << " postfix expression: " << out << "\n";
+    value_ = uint32_t(stack[0]);
+    length_ = 3;
+    evaluated_ = true;
+    epoch_ = symbols_->epoch();
+    return status_t();
   }
 
-  int expression::evaluate_postfix(std::string in_expr/*, std::vector<std::string> in_operands*/)
+  status_t expression::relocation_terms(terms_t& out_terms) const
   {
-    string_t out = "";
+    out_terms.clear();
 
-    std::vector<string_t> operands;
-    uint64_t result_ = 0x0;
-    string_t operand_str = "";
-    for (char c : in_expr)
-    {
-      if (c == ' ')
-      {
-        if (!operand_str.empty())
-        {
-          operands.push_back(operand_str);
-          operand_str = "";
-        }
-        continue;
-      }
+    // every stack entry is a sub-expression, and since the program is postfix
+    // the terms of two adjacent entries are adjacent too; an entry is the
+    // offset of its first term
+    size_t stack[max_depth];
+    size_t top = 0;
 
-      if (!is_operator(c))
+    for (op_t const& op : program_)
+    {
+      switch (op.code)
       {
-        operand_str += c;
-        continue;
-      }
+        case op_t::o_number:
+          stack[top++] = out_terms.size();
+          break;
 
-      //~ std::cout << "applying op " << c << " on 2-top operands : " << operands.size() << ":";
-
-      assert(operands.size() >= 2);
-      string_t tmp = operands.back();
-      operands.pop_back();
-      string_t res = operands.back() + c + tmp;
+        case op_t::o_symbol:
+        {
+          stack[top++] = out_terms.size();
 
-      result_ = apply_operator(c, utility::convertTo<int>(operands.back()), utility::convertTo<int>(tmp));
+          symbol_t const* sym = symbols_->lookup(symbol_id_t(op.arg));
+          if (sym && sym->is_external_ref())
+            out_terms.push_back({ symbol_id_t(op.arg), 1 });
+          break;
+        }
 
-      operands.pop_back();
-      operands.push_back(stringify(result_));
-    }
+        case op_t::o_negate:
+          for (size_t i = stack[top-1]; i < out_terms.size(); ++i)
+            out_terms[i].weight = -out_terms[i].weight;
+          break;
 
-    out = operands.back();
-    //~ std::cout << "result of postfix expression: " << in_expr << " = " << result_ << "\n";
+        case op_t::o_subtract:
+          for (size_t i = stack[top-1]; i < out_terms.size(); ++i)
+            out_terms[i].weight = -out_terms[i].weight;
+          // fall through
 
-    return result_;
-  }
+        case op_t::o_add:
+        {
+          // fold the terms of both operands into one set, the weights of a
+          // reference that appears more than once are summed up
+          --top;
+          size_t end = stack[top];
+          for (size_t i = stack[top]; i < out_terms.size(); ++i)
+          {
+            size_t j = stack[top-1];
+            while (j < end && out_terms[j].symbol != out_terms[i].symbol)
+              ++j;
+
+            if (j < end)
+              out_terms[j].weight += out_terms[i].weight;
+            else
+              out_terms[end++] = out_terms[i];
+          }
+
+          while (out_terms.size() > end)
+            out_terms.pop_back();
+
+          // and drop the ones that cancelled out
+          end = stack[top-1];
+          for (size_t i = stack[top-1]; i < out_terms.size(); ++i)
+            if (out_terms[i].weight != 0)
+              out_terms[end++] = out_terms[i];
+
+          while (out_terms.size() > end)
+            out_terms.pop_back();
+          break;
+        }
 
-  int expression::apply_operator(char op, int lhs, int rhs)
-  {
-    switch (op)
-    {
-      case '*':
-      return lhs * rhs;
-      case '/':
-      return lhs / rhs;
-      case '+':
-      return lhs + rhs;
-      case '-':
-      return lhs - rhs;
-      case '%':
-      return lhs % rhs;
-      default:
-      string_t msg = "unrecognized expression operation '";
-      msg += op;
-      msg += '\'';
-      throw invalid_operator(msg, (inst_ ? inst_->line() : token_));
+        default:
+          // the address of an external reference is only known once the
+          // program is loaded, it can only be added or subtracted
+          if (out_terms.size() > stack[top-2])
+            return __fail("external reference '" + string_t(symbols_->name(out_terms[stack[top-2]].symbol))
+                          + "' can only be added or subtracted", op.position);
+          --top;
+      }
     }
 
-    return 0;
+    assert(top == 1);
+    return status_t();
   }
 
   expression::extrefs_t& expression::references()
@@ -299,5 +465,8 @@ namespace hax
     return extrefs_;
   }
 
+  expression::program_t const& expression::program() const
+  {
+    return program_;
+  }
 } // end of namespace
-
@@ -25,10 +25,9 @@
 
 namespace hax
 {
-  using utility::stringify;
-
-	symbol::symbol(string_t const& in_label, instruction* in_inst)
+	symbol::symbol(std::string_view in_label, symbol_id_t in_id, instruction* in_inst)
   : operand(in_label, 0),
+    id_(in_id),
     address_(0x0),
     user_defined_(false),
     external_ref_(false),
@@ -45,7 +44,7 @@ namespace hax
 	{
 	}
 
-  symbol::symbol(const symbol& src) : operand(src.token_, src.inst_)
+  symbol::symbol(const symbol& src) : operand(src.token_, src.inst_), id_(src.id_)
   {
     copy_from(src);
   }
@@ -78,8 +77,14 @@ namespace hax
     return in;
   }
 
-  void symbol::evaluate()
+  status_t symbol::evaluate()
+  {
+    return status_t();
+  }
+
+  symbol_id_t symbol::id() const
   {
+    return id_;
   }
 
   void symbol::assign_address(loc_t in_address)
@@ -102,6 +107,11 @@ namespace hax
     user_defined_ = f;
   }
 
+  void symbol::__withdraw()
+  {
+    evaluated_ = false;
+  }
+
   bool symbol::is_user_defined() const
   {
     return user_defined_;
@@ -0,0 +1,236 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "optable.hpp"
+#include "instruction.hpp"
+#include <cstdint>
+#include <cassert>
+
+namespace hax
+{
+  namespace {
+    constexpr format_t fmt_3_4 = format::fmt_three | format::fmt_four;
+
+    constexpr op_t ops[] = {
+      { "ADD",    m_add,         0x18, fmt_3_4 },
+      { "ADDR",   m_addr,        0x90, format::fmt_two },
+      { "AND",    m_and,         0x40, fmt_3_4 },
+      { "CLEAR",  m_clear,       0xB4, format::fmt_two },
+      { "COMP",   m_comp,        0x28, fmt_3_4 },
+      { "COMPR",  m_compr,       0xA0, format::fmt_two },
+      { "DIV",    m_div,         0x24, fmt_3_4 },
+      { "DIVR",   m_divr,        0x9C, format::fmt_two },
+      { "HIO",    m_hio,         0xF4, format::fmt_one },
+      { "J",      m_j,           0x3C, fmt_3_4 },
+      { "JEQ",    m_jeq,         0x30, fmt_3_4 },
+      { "JGT",    m_jgt,         0x34, fmt_3_4 },
+      { "JLT",    m_jlt,         0x38, fmt_3_4 },
+      { "JSUB",   m_jsub,        0x48, fmt_3_4 },
+      { "LDA",    m_lda,         0x00, fmt_3_4 },
+      { "LDB",    m_ldb,         0x68, fmt_3_4 },
+      { "LDCH",   m_ldch,        0x50, fmt_3_4 },
+      { "LDF",    m_ldf,         0x70, fmt_3_4 },
+      { "LDL",    m_ldl,         0x08, fmt_3_4 },
+      { "LDS",    m_lds,         0x6C, fmt_3_4 },
+      { "LDT",    m_ldt,         0x74, fmt_3_4 },
+      { "LDX",    m_ldx,         0x04, fmt_3_4 },
+      { "MUL",    m_mul,         0x20, fmt_3_4 },
+      { "OR",     m_or,          0x44, format::fmt_two },
+      { "RD",     m_rd,          0xD8, fmt_3_4 },
+      { "RSUB",   m_rsub,        0x4C, fmt_3_4 },
+      { "SHIFTL", m_shiftl,      0xA4, format::fmt_two },
+      { "SHIFTR", m_shiftr,      0xA8, format::fmt_two },
+      { "SIO",    m_sio,         0xF0, format::fmt_one },
+      { "STA",    m_sta,         0x0C, fmt_3_4 },
+      { "STB",    m_stb,         0x78, fmt_3_4 },
+      { "STCH",   m_stch,        0x54, fmt_3_4 },
+      { "STI",    m_sti,         0xD4, fmt_3_4 },
+      { "STL",    m_stl,         0x14, fmt_3_4 },
+      { "STS",    m_sts,         0x7C, fmt_3_4 },
+      { "STSW",   m_stsw,        0xE8, fmt_3_4 },
+      { "STT",    m_stt,         0x84, fmt_3_4 },
+      { "STX",    m_stx,         0x10, fmt_3_4 },
+      { "SUB",    m_sub,         0x1C, fmt_3_4 },
+      { "SUBR",   m_subr,        0x94, format::fmt_two },
+      { "TD",     m_td,          0xE0, fmt_3_4 },
+      { "TIO",    m_tio,         0xF8, format::fmt_one },
+      { "TIX",    m_tix,         0x2C, fmt_3_4 },
+      { "TIXR",   m_tixr,        0xB8, format::fmt_two },
+      { "WD",     m_wd,          0xDC, fmt_3_4 },
+
+      { "START",  m_start,       0x00, format::fmt_directive },
+      { "CSECT",  m_csect,       0x00, format::fmt_directive },
+      { "END",    m_end,         0x00, format::fmt_directive },
+      { "EXTREF", m_extref,      0x00, format::fmt_directive },
+      { "EXTDEF", m_extdef,      0x00, format::fmt_directive },
+      { "USE",    m_use,         0x00, format::fmt_directive },
+      { "EQU",    m_equ,         0x00, format::fmt_directive },
+      { "RESW",   m_resw,        0x00, format::fmt_directive },
+      { "RESB",   m_resb,        0x00, format::fmt_directive },
+      { "BYTE",   m_byte,        0x00, format::fmt_directive },
+      { "WORD",   m_word,        0x00, format::fmt_directive },
+      { "ORG",    m_org,         0x00, format::fmt_directive }, // TODO: implement
+      { "LTORG",  m_ltorg,       0x00, format::fmt_directive },
+      { "BASE",   m_base,        0x00, format::fmt_directive },
+      { "*",      m_current_loc, 0x00, format::fmt_directive }
+    };
+
+    constexpr size_t nr_ops = sizeof(ops) / sizeof(ops[0]);
+
+    // slots hold an index into ops, or nil_slot if no mnemonic hashes there
+    constexpr size_t nr_slots = 256;
+    constexpr uint8_t nil_slot = 0xFF;
+
+    static_assert(nr_ops < nil_slot, "the optable has outgrown its slot indices");
+    static_assert(nr_ops == m_literal, "every optable mnemonic needs an ID, and vice versa");
+
+    constexpr bool ids_match_positions()
+    {
+      for (size_t i = 0; i < nr_ops; ++i)
+        if (ops[i].id != i)
+          return false;
+
+      return true;
+    }
+
+    // optable::get() indexes the table by ID
+    static_assert(ids_match_positions(), "optable entries must be listed in the order of their IDs");
+
+    constexpr bool has_duplicates()
+    {
+      for (size_t i = 0; i < nr_ops; ++i)
+        for (size_t j = i + 1; j < nr_ops; ++j)
+          if (ops[i].mnemonic == ops[j].mnemonic)
+            return true;
+
+      return false;
+    }
+
+    // a mnemonic registered twice, even with another format, is ambiguous
+    static_assert(!has_duplicates(), "a mnemonic is registered more than once in the optable");
+
+    constexpr bool fits_length_filter()
+    {
+      for (size_t i = 0; i < nr_ops; ++i)
+        if (ops[i].mnemonic.empty() || ops[i].mnemonic.size() >= 32)
+          return false;
+
+      return true;
+    }
+
+    static_assert(fits_length_filter(), "optable mnemonics must be 1 to 31 characters long");
+
+    constexpr uint32_t hash(std::string_view in_token, uint32_t in_seed)
+    {
+      // FNV-1a
+      uint32_t h = 2166136261u ^ in_seed;
+      for (char c : in_token)
+        h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+
+      return (h ^ (h >> 15)) % nr_slots;
+    }
+
+    constexpr bool is_perfect(uint32_t in_seed)
+    {
+      bool taken[nr_slots] = {};
+      for (size_t i = 0; i < nr_ops; ++i)
+      {
+        uint32_t slot = hash(ops[i].mnemonic, in_seed);
+        if (taken[slot])
+          return false;
+
+        taken[slot] = true;
+      }
+
+      return true;
+    }
+
+    constexpr uint32_t max_seed = 1 << 16;
+
+    constexpr uint32_t find_seed()
+    {
+      uint32_t seed = 0;
+      while (seed < max_seed && !is_perfect(seed))
+        ++seed;
+
+      return seed;
+    }
+
+    constexpr uint32_t seed = find_seed();
+
+    static_assert(seed < max_seed, "no perfect hash was found for the optable mnemonics");
+
+    struct lookup_table_t {
+      uint8_t slots[nr_slots];
+
+      /* bit N is set if a mnemonic of length N is registered */
+      uint32_t lengths;
+
+      /* bit C is set if a mnemonic begins with the character C */
+      uint64_t first_chars[4];
+
+      constexpr lookup_table_t() : slots(), lengths(0), first_chars()
+      {
+        for (size_t i = 0; i < nr_slots; ++i)
+          slots[i] = nil_slot;
+
+        for (size_t i = 0; i < nr_ops; ++i)
+        {
+          uint8_t c = static_cast<uint8_t>(ops[i].mnemonic[0]);
+
+          slots[hash(ops[i].mnemonic, seed)] = static_cast<uint8_t>(i);
+          lengths |= uint32_t(1) << ops[i].mnemonic.size();
+          first_chars[c >> 6] |= uint64_t(1) << (c & 63);
+        }
+      }
+    };
+
+    constexpr lookup_table_t lookup_table;
+
+  }
+
+  const op_t* optable::find(std::string_view in_mnemonic)
+  {
+    size_t len = in_mnemonic.size();
+    if (len == 0 || len >= 32 || !(lookup_table.lengths & (uint32_t(1) << len)))
+      return 0;
+
+    uint8_t c = static_cast<uint8_t>(in_mnemonic[0]);
+    if (!(lookup_table.first_chars[c >> 6] & (uint64_t(1) << (c & 63))))
+      return 0;
+
+    uint8_t idx = lookup_table.slots[hash(in_mnemonic, seed)];
+    if (idx == nil_slot || ops[idx].mnemonic != in_mnemonic)
+      return 0;
+
+    return &ops[idx];
+  }
+
+  const op_t& optable::get(mnemonic_id_t in_id)
+  {
+    assert(in_id < nr_ops);
+    return ops[in_id];
+  }
+
+  size_t optable::size()
+  {
+    return nr_ops;
+  }
+} // end of namespace
@@ -23,11 +23,17 @@
 #include "symbol_manager.hpp"
 #include "instruction_factory.hpp"
 #include "serializer.hpp"
+#include "source_reader.hpp"
+#include "tokenizer.hpp"
+#include "line_scanner.hpp"
+#include "hax_stats.hpp"
+#include "optable.hpp"
 #include <fstream>
 #include <ostream>
 #include <exception>
 #include <stdexcept>
 #include <typeinfo>
+#include <memory>
 
 namespace hax
 {
@@ -36,15 +42,28 @@ namespace hax
 	parser* parser::__instance = 0;
 
 	parser::parser()
+  : csect_(0),
+    base_(0)
   {
-    populate_optable();
+    std::cout << "+- Registered " << optable::size() << " SIC/XE operations & assembler directives.\n";
 	}
 
 	parser::~parser()
 	{
-
+    release_sections();
 	}
 
+  void parser::release_sections()
+  {
+    while (!csects_.empty())
+    {
+      delete csects_.back();
+      csects_.pop_back();
+    }
+
+    csect_ = 0;
+  }
+
 	parser* parser::singleton_ptr()
   {
 		return __instance = (!__instance) ? new parser() : __instance;
@@ -55,140 +74,33 @@ namespace hax
 		return *singleton_ptr();
 	}
 
-  void parser::register_op(std::string in_mnemonic, opcode_t in_code, format_t in_fmt)
-  {
-    optable_.insert(std::make_pair(in_mnemonic, std::make_tuple(in_code, in_fmt)));
-  }
-
-  void parser::populate_optable()
-  {
-    register_op("ADD",    0x18, format::fmt_three | format::fmt_four);
-    register_op("ADDR",   0x90, format::fmt_two);
-    register_op("AND",    0x40, format::fmt_three | format::fmt_four);
-    register_op("CLEAR",  0xB4, format::fmt_two);
-    register_op("COMP",   0x28, format::fmt_three | format::fmt_four);
-    register_op("COMPR",  0xA0, format::fmt_two);
-    register_op("DIV",    0x24, format::fmt_three | format::fmt_four);
-    register_op("DIVR",   0x9C, format::fmt_two);
-    register_op("HIO",    0xF4, format::fmt_one);
-    register_op("J",      0x3C, format::fmt_three | format::fmt_four);
-    register_op("JEQ",    0x30, format::fmt_three | format::fmt_four);
-    register_op("JGT",    0x34, format::fmt_three | format::fmt_four);
-    register_op("JLT",    0x38, format::fmt_three | format::fmt_four);
-    register_op("JSUB",   0x48, format::fmt_three | format::fmt_four);
-    register_op("LDA",    0x00, format::fmt_three | format::fmt_four);
-    register_op("LDB",    0x68, format::fmt_three | format::fmt_four);
-    register_op("LDCH",   0x50, format::fmt_three | format::fmt_four);
-    register_op("LDF",    0x70, format::fmt_three | format::fmt_four);
-    register_op("LDL",    0x08, format::fmt_three | format::fmt_four);
-    register_op("LDS",    0x6C, format::fmt_three | format::fmt_four);
-    register_op("LDT",    0x74, format::fmt_three | format::fmt_four);
-    register_op("LDX",    0x04, format::fmt_three | format::fmt_four);
-    register_op("MUL",    0x20, format::fmt_three | format::fmt_four);
-    register_op("OR",     0x44, format::fmt_two);
-    register_op("RD",     0xD8, format::fmt_three | format::fmt_four);
-    register_op("RSUB",   0x4C, format::fmt_three | format::fmt_four);
-    register_op("SHIFTL", 0xA4, format::fmt_two);
-    register_op("SHIFTR", 0xA8, format::fmt_two);
-    register_op("SIO",    0xF0, format::fmt_one);
-    register_op("STA",    0x0C, format::fmt_three | format::fmt_four);
-    register_op("STB",    0x78, format::fmt_three | format::fmt_four);
-    register_op("STCH",   0x54, format::fmt_three | format::fmt_four);
-    register_op("STI",    0xD4, format::fmt_three | format::fmt_four);
-    register_op("STL",    0x14, format::fmt_three | format::fmt_four);
-    register_op("STS",    0x7C, format::fmt_three | format::fmt_four);
-    register_op("STSW",   0xE8, format::fmt_three | format::fmt_four);
-    register_op("STT",    0x84, format::fmt_three | format::fmt_four);
-    register_op("STX",    0x10, format::fmt_three | format::fmt_four);
-    register_op("SUB",    0x1C, format::fmt_three | format::fmt_four);
-    register_op("SUBR",   0x94, format::fmt_two);
-    register_op("TD",     0xE0, format::fmt_three | format::fmt_four);
-    register_op("TIO",    0xF8, format::fmt_one);
-    register_op("TIX",    0x2C, format::fmt_three | format::fmt_four);
-    register_op("TIXR",   0xB8, format::fmt_two);
-    register_op("WD",     0xDC, format::fmt_three | format::fmt_four);
-
-    register_op("START",  0x00, format::fmt_directive);
-    register_op("CSECT",  0x00, format::fmt_directive);
-    register_op("END",    0x00, format::fmt_directive);
-    register_op("EXTREF", 0x00, format::fmt_directive); // TODO: implement
-    register_op("EXTDEF", 0x00, format::fmt_directive); // TODO: implement
-    register_op("USE",    0x00, format::fmt_directive);
-    register_op("CLEAR",  0x00, format::fmt_directive);
-    register_op("EQU",    0x00, format::fmt_directive);
-    register_op("RESW",   0x00, format::fmt_directive);
-    register_op("RESB",   0x00, format::fmt_directive);
-    register_op("BYTE",   0x00, format::fmt_directive);
-    register_op("WORD",   0x00, format::fmt_directive);
-    register_op("ORG",    0x00, format::fmt_directive); // TODO: implement
-    register_op("LTORG",  0x00, format::fmt_directive); // TODO: implement
-    register_op("BASE",   0x00, format::fmt_directive);
-    register_op("*",      0x00, format::fmt_directive); // TODO: implement
-
-    std::cout << "+- Registered " << optable_.size() << " SIC/XE operations & assembler directives.\n";
-  }
-
-  bool parser::is_op(string_t const& in_token) const
+  bool parser::is_op(std::string_view in_token) const
   {
-    string_t token(in_token);
-    if (token[0] == '+')
-      token = token.substr(1, token.size());
+    if (!in_token.empty() && in_token.front() == '+')
+      in_token.remove_prefix(1);
 
-    return optable_.find(token) != optable_.end();
+    return optable::find(in_token) != 0;
   }
 
-  bool parser::is_directive(string_t const& in_token) const
+  bool parser::is_directive(std::string_view in_token) const
   {
-    string_t token(in_token);
-    if (token[0] == '+')
-      token = token.substr(1, token.size());
-
-    optable_t::const_iterator entry = optable_.find(token);
-    if (entry == optable_.end())
-      return false;
+    if (!in_token.empty() && in_token.front() == '+')
+      in_token.remove_prefix(1);
 
-    return std::get<1>(entry->second) == format::fmt_directive;
-  }
-
-  bool parser::is_delimiter(char c)
-  {
-    switch(c)
-    {
-      case ' ':
-      case '\t':
-      return true;
-
-      default:
-      return false;
-    }
-
-    return false;
-  }
-
-  opcode_fmt_t parser::opcode_from_token(string_t const& in_token, int* ec)
-  {
-    string_t token = in_token;
-    if (token[0] == '+')
-      token = token.substr(1, token.size());
-
-    optable_t::const_iterator opcode = optable_.find(token);
-    if (opcode == optable_.end())
-    {
-      *ec = 1;
-      return std::make_tuple(0,0);
-    }
-
-    *ec = 0;
-    return opcode->second;
+    const op_t* op = optable::find(in_token);
+    return op && op->fmt == format::fmt_directive;
   }
 
   void parser::process(string_t const& in_path, string_t const& out_path)
   {
-    std::ifstream in(in_path);
-    if (!in.is_open() || !in.good())
-    {
-      throw std::runtime_error("can not open input file: " + in_path);
-    }
+    std::unique_ptr<source_reader> in(source_reader::open(in_path));
+
+    // the sections, and everything in their arenas, are only needed until
+    // they have been serialized
+    struct sections_guard_t {
+      parser* owner;
+      ~sections_guard_t() { owner->release_sections(); }
+    } sections_guard = { this };
 
     // __DEBUG__ : skip the START record
     //~ while (in.get() != '\n');;
@@ -196,153 +108,109 @@ namespace hax
     std::cout << "+- Pass1: \n";
     std::cout << "+- \n";
     std::cout << "+- Analyzing entries...\n";
-    int line_nr = 0;
+    if (VERBOSE)
+      std::cout << "+- Scanning input using the " << line_scanner::isa() << " line scanner\n";
+
+    uint64_t heap_allocations = stats::heap_allocations;
 
-    while (!in.eof())
-    //~ for (int i=0; i < 4; ++i)
+    source_reader::block_t block;
+    line_scanner::lines_t lines;
+    entry_t entry;
+    while (in->next_block(block))
     {
-      string_t line = "";
-      ++line_nr;
+      // locate the fields of every line in the block, blank and comment lines
+      // carry nothing and are not reported by the scanner
+      lines.clear();
+      line_scanner::scan(block.data, block.length, lines);
 
-      // parse the line first
-      while (true)
+      for (scanned_line_t const& scanned : lines)
       {
-        char c = in.get();
-        if (c == '\n' || in.eof())
-          break;
-
-        line += c;
-      }
-
-      // discard the last empty-line entry
-      if (in.eof())
-        break;
-
-      { // prepare the entry for parsing
-
-        // trim whitespace
-        utility::itrim(line);
-
-        // is it a full comment? if so, discard this entry
-        if (line.front() == '.' || line.front() == ';')
+        ++stats::lines;
+        if (!track_error(tokenizer::tokenize(block.data, scanned, entry)))
           continue;
 
-        // remove any inline comments
-        size_t comment_idx = line.find('.');
-        if (comment_idx != std::string::npos) {
-          line = line.substr(0, comment_idx);
-          // re-trim in case there were spaces before the comment
-          utility::itrim(line);
-        }
+        instruction* inst = 0;
+        symbol_t* label = 0;
 
-        comment_idx = line.find(';');
-        if (comment_idx != std::string::npos) {
-          line = line.substr(0, comment_idx);
-          // re-trim in case there were spaces before the comment
-          utility::itrim(line);
+        // check whether this is a CSECT or START entry
+        if (entry.has(entry_t::r_label) && entry.op &&
+           (entry.op->id == m_start || entry.op->id == m_csect))
+        {
+          __register_section(string_t(entry.label()), string_t(entry.line));
         }
-      } // entry preparation block
 
-      //~ std::cout << "Entry is now ready for parsing: '" << line << "'\n";
+        // if by now we were not assigned a control section, abort
+        if (!csect_) {
+          throw invalid_context("an input program must begin with a START or CSECT entry to define a control section!");
+        }
 
-      // parse tokens and register them
+        // the block is recycled once the next one is read, the instruction
+        // keeps its line and operand so they are moved into the section
+        if (!in->persistent())
+          tokenizer::copy_into(csect_->arena(), entry);
 
-      std::list<string_t> tokens;
-      string_t token = "";
-      for (char c : line)
-      {
-        if (is_delimiter(c))
+        // entries that can not be made into an instruction are reported and
+        // skipped, the rest of the program is still checked
+        if (entry.has(entry_t::r_label))
         {
-          if (!token.empty())
+          if (csect_->symmgr()->is_defined(entry.label()))
           {
-            //inst->register_token(token);
-            tokens.push_back(token);
-            token.clear();
+            symbol_redifinition e("token '" + string_t(entry.label()) + "'", string_t(entry.line));
+            track_error(e);
+            continue;
           }
-        } else
-        {
-          token += c;
+
+          label = csect_->symmgr()->declare(entry.label());
         }
-      }
 
-      if (!token.empty())
-        tokens.push_back(token);
+        // validation check: was it only a label entry?
+        if (!entry.has(entry_t::r_mnemonic))
+        {
+          invalid_entry e("missing opcode and operands in entry: ", string_t(entry.line));
+          track_error(e);
+          continue;
+        }
+        else if (!entry.op)
+        {
+          invalid_entry e("unrecognized operation: " + string_t(entry.mnemonic()), string_t(entry.line));
+          track_error(e);
+          continue;
+        }
 
-      if (tokens.empty())
-        continue;
+        if (!track_error(instruction_factory::singleton().create(entry, csect_->block(), inst)))
+          continue;
 
-      instruction* inst = 0;
-      symbol_t* label = 0;
+        if (label)
+          inst->assign_label(label);
 
-      // check whether this is a CSECT or START entry
-      if (tokens.size() >= 2 && (line.find("START") != std::string::npos || line.find("CSECT") != std::string::npos))
-      {
-        __register_section(tokens.front(), line);
-      }
+        inst->assign_line(entry.line);
 
-      // if by now we were not assigned a control section, abort
-      if (!csect_) {
-        throw invalid_context("an input program must begin with a START or CSECT entry to define a control section!");
-      }
+        // assign the operand
+        bool has_operand = true;
+        if (entry.has(entry_t::r_operand))
+          has_operand = track_error(inst->assign_operand(entry.operand(), entry.flags));
 
-      // find out whether the first token is a label or an opcode
-      if (!is_op(tokens.front()))
-      {
-        if (csect_->symmgr()->is_defined(tokens.front()))
-          throw symbol_redifinition("token '" + tokens.front() + "'", line);
+        csect_->block()->add_instruction(inst);
 
-        try {
-          label = csect_->symmgr()->declare(tokens.front());
-          tokens.pop_front();
-        } catch (hax_error& e) {
-          track_error(e);
-          continue; // can't proceed if label couldn't be defined
-        }
-      }
+        // an operand that could not be created has already been reported, and
+        // there is nothing for the instruction to be prepared with
+        if (has_operand)
+          track_error(inst->preprocess());
 
-      // validation check: was it only a label entry?
-      if (tokens.empty())
-        throw invalid_entry("missing opcode and operands in entry: ", line);
+        track_error(csect_->block()->step(inst));
 
-      else if (!is_op(tokens.front()))
-        throw invalid_entry("unrecognized operation: " + tokens.front(), line);
+        std::cout << inst << "\n";
 
-      try {
-        inst = instruction_factory::singleton().create(tokens.front(), csect_->block());
-        tokens.pop_front();
-      } catch (hax_error& e)
-      {
-        track_error(e);
+        inst = 0;
       }
+    }
 
-      if (label)
-        inst->assign_label(label);
-
-      // assign label & operands
-      assert(tokens.size() <= 1);
-      for (auto _token : tokens)
-      {
-        try {
-          inst->assign_operand(_token);
-        } catch (hax_error& e)
-        {
-          track_error(e);
-        }
-      }
-
-      inst->assign_line(line);
-      csect_->block()->add_instruction(inst);
-      try {
-        inst->preprocess();
-      } catch (hax_error& e) {
-        track_error(e);
-      }
-      csect_->block()->step(inst);
-
-      std::cout << inst << "\n";
+    stats::pass1_heap_allocations = stats::heap_allocations - heap_allocations;
 
-      inst = 0;
-    }
+    // EQU directives referring to symbols that are defined further down are
+    // resolved now that every entry has been read
+    for (auto sect : csects_)
+      sect->symmgr()->resolve_definitions();
 
     std::cout << "+-\n";
     if (VERBOSE)
@@ -366,18 +234,19 @@ namespace hax
     std::cout << "+- Pass2\n";
     std::cout << "+- Assembling object code...\n";
 
-    for (auto sect : csects_) {
+    for (auto sect : csects_)
       sect->assemble();
-      sect->serialize(out_path);
-    }
-
-    in.close();
 
     std::cout << "+- Pass2: " << (errors_.empty() ? "complete" : "failed") << "\n";
     if (!errors_.empty())
     {
+      // a section that failed to assemble has no meaningful object code, so
+      // nothing is written out
       return report_errors();
     }
+
+    for (auto sect : csects_)
+      sect->serialize(out_path);
   }
 
   loc_t parser::base() const
@@ -437,4 +306,12 @@ namespace hax
       << " (in \"" << err.source() << "\")\n";
     errors_.push_back(s.str());
   }
+
+  bool parser::track_error(status_t const& in_status)
+  {
+    if (!in_status.ok())
+      track_error(in_status.error());
+
+    return in_status.ok();
+  }
 } // end of namespace
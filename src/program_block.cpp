@@ -23,17 +23,19 @@
 
 namespace hax
 {
-  program_block::program_block(string_t in_name, csect_t* in_sect)
+  program_block::program_block(string_t in_name, uint16_t in_id, csect_t* in_sect)
   : locctr_(0),
     name_(in_name),
-    sect_(in_sect)
+    id_(in_id),
+    sect_(in_sect),
+    last_(0)
   {
   }
 
   program_block::~program_block()
   {
-    instructions_.clear();
     sect_ = 0;
+    last_ = 0;
   }
 
   loc_t program_block::locctr() const
@@ -46,43 +48,47 @@ namespace hax
     return name_;
   }
 
+  uint16_t program_block::id() const
+  {
+    return id_;
+  }
+
   void program_block::add_instruction(instruction_t* in_inst)
   {
     in_inst->__assign_block(this);
-    in_inst->assign_location(locctr_);
 
     sect_->__add_instruction(in_inst);
-    instructions_.push_back(in_inst);
-  }
-
-  program_block::instructions_t const&
-  program_block::instructions() const
-  {
-    return instructions_;
+    in_inst->assign_location(locctr_);
+    last_ = in_inst;
   }
 
-  void program_block::step(instruction* inst)
+  status_t program_block::step(instruction* inst)
   {
     if (!inst) {
-      if (instructions_.empty())
-        return;
+      if (!last_)
+        return status_t();
 
-      inst = instructions_.back();
+      inst = last_;
     }
 
     std::cout << "Program block " << name_
       << " location counter stepping to " << locctr_ + inst->length()
       << " from " << locctr_ << " in " << inst << "\n";
+    loc_t locctr = locctr_;
     locctr_ += inst->length();
 
-  }
+    sect_->instructions().record_pass1(inst->handle());
 
-  void program_block::shift(int in_amount)
-  {
-    for (auto inst : instructions_)
+    if (locctr <= address_space && (locctr_ > address_space || locctr_ < locctr))
     {
-      inst->assign_location(inst->location() + in_amount);
+      std::ostringstream msg;
+      msg << "program block '" << name_ << "' runs past the 20-bit address space at 0x"
+        << std::hex << std::uppercase << locctr;
+
+      return status_t::failure(address_overflow(msg.str(), inst->line()));
     }
+
+    return status_t();
   }
 
   size_t program_block::length() const
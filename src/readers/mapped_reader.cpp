@@ -0,0 +1,99 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "readers/mapped_reader.hpp"
+#include <cstring>
+#include <limits>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace hax
+{
+  mapped_reader::mapped_reader(string_t const& in_path, int in_fd, offset_t in_size)
+  : source_reader(in_path),
+    data_(0),
+    size_(in_size),
+    cursor_(0),
+    fd_(in_fd)
+  {
+    // there is nothing to map in an empty file, and mmap() refuses a length of 0
+    if (size_ == 0)
+      return;
+
+    if (size_ > std::numeric_limits<size_t>::max())
+    {
+      ::close(fd_);
+      throw std::runtime_error("input file is too large to be mapped: " + in_path);
+    }
+
+    void* addr = ::mmap(0, static_cast<size_t>(size_), PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (addr == MAP_FAILED)
+    {
+      ::close(fd_);
+      throw std::runtime_error("can not map input file: " + in_path);
+    }
+
+    // lines are consumed front to back exactly once
+    ::madvise(addr, static_cast<size_t>(size_), MADV_SEQUENTIAL);
+
+    data_ = static_cast<const char*>(addr);
+  }
+
+  mapped_reader::~mapped_reader()
+  {
+    if (data_)
+      ::munmap(const_cast<char*>(data_), static_cast<size_t>(size_));
+
+    if (fd_ != -1)
+      ::close(fd_);
+
+    data_ = 0;
+    fd_ = -1;
+  }
+
+  bool mapped_reader::next_block(block_t& out_block)
+  {
+    if (cursor_ >= size_)
+      return false;
+
+    offset_t end = size_;
+    if (block_size < size_ - cursor_)
+    {
+      // extend the block to the end of the line it stops in
+      const char* last = data_ + cursor_ + block_size - 1;
+      const char* newline =
+        static_cast<const char*>(::memchr(last, '\n', static_cast<size_t>(data_ + size_ - last)));
+
+      if (newline)
+        end = static_cast<offset_t>(newline - data_) + 1;
+    }
+
+    out_block.data = data_ + cursor_;
+    out_block.length = static_cast<size_t>(end - cursor_);
+    out_block.offset = cursor_;
+    cursor_ = end;
+    return true;
+  }
+
+  bool mapped_reader::persistent() const
+  {
+    return true;
+  }
+} // end of namespace
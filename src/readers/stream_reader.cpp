@@ -0,0 +1,118 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "readers/stream_reader.hpp"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+namespace hax
+{
+  stream_reader::stream_reader(string_t const& in_path, int in_fd, bool in_owns_fd)
+  : source_reader(in_path),
+    buffer_(block_size),
+    begin_(0),
+    end_(0),
+    offset_(0),
+    fd_(in_fd),
+    owns_fd_(in_owns_fd),
+    eof_(false)
+  {
+  }
+
+  stream_reader::~stream_reader()
+  {
+    if (owns_fd_ && fd_ != -1)
+      ::close(fd_);
+
+    fd_ = -1;
+  }
+
+  void stream_reader::fill()
+  {
+    while (!eof_ && end_ < buffer_.size())
+    {
+      ssize_t nr_read = ::read(fd_, &buffer_[end_], buffer_.size() - end_);
+      if (nr_read == -1)
+      {
+        if (errno == EINTR)
+          continue;
+
+        throw std::runtime_error("can not read input: " + path_ + ": " + std::strerror(errno));
+      }
+
+      if (nr_read == 0)
+        eof_ = true;
+
+      end_ += static_cast<size_t>(nr_read);
+    }
+  }
+
+  bool stream_reader::next_block(block_t& out_block)
+  {
+    if (eof_ && begin_ == end_)
+      return false;
+
+    // the last block is no longer referred to, so the partial line trailing
+    // it is moved to the front and the rest of the buffer is reused
+    if (begin_ > 0)
+    {
+      std::memmove(&buffer_[0], &buffer_[begin_], end_ - begin_);
+      end_ -= begin_;
+      begin_ = 0;
+    }
+
+    while (true)
+    {
+      fill();
+
+      if (end_ == 0)
+        return false;
+
+      // hand out every complete line in the buffer
+      const char* data = &buffer_[0];
+      const char* newline = static_cast<const char*>(::memrchr(data, '\n', end_));
+      if (newline)
+        begin_ = static_cast<size_t>(newline - data) + 1;
+
+      // the last line of the input might not be terminated by a newline
+      else if (eof_)
+        begin_ = end_;
+
+      // a single line does not fit in the buffer, so it has to grow
+      else
+      {
+        buffer_.resize(buffer_.size() * 2);
+        continue;
+      }
+
+      out_block.data = data;
+      out_block.length = begin_;
+      out_block.offset = offset_;
+      offset_ += begin_;
+      return true;
+    }
+  }
+
+  bool stream_reader::persistent() const
+  {
+    return false;
+  }
+} // end of namespace
@@ -26,6 +26,7 @@
 #include <ostream>
 #include <exception>
 #include <stdexcept>
+#include <algorithm>
 
 namespace hax
 {
@@ -53,14 +54,21 @@ namespace hax
 		return *singleton_ptr();
 	}
 
-  bool serializer::requires_new_trecord(t_record* rec, instruction_t* inst)
+  bool serializer::requires_new_trecord(t_record* rec, instruction_store const& in_store, instruction_store::handle_t i)
   {
     if (rec->length >= t_record::maxlen)
       return true;
-    if (inst->mnemonic() == "RESW" || inst->mnemonic() == "RESB" || inst->mnemonic() == "USE")
-      return true;
-    if (rec->length + inst->length() > t_record::maxlen) {
-      //~ std::cout << "IM HERE ! " << rec->length << " + " << inst->length() << "\n";
+    switch (in_store.mnemonic_id(i))
+    {
+      case m_resw:
+      case m_resb:
+      case m_use:
+        return true;
+      default:
+        break;
+    }
+    if (rec->length + in_store.length(i) > t_record::maxlen) {
+      //~ std::cout << "IM HERE ! " << rec->length << " + " << in_store.length(i) << "\n";
       return true;
     }
 
@@ -76,7 +84,7 @@ namespace hax
     }
 
     std::cout << "+- Serializer: writing object program\n";
-    std::list<instruction_t*> const& instructions = in_sect->instructions();
+    instruction_store const& instructions = in_sect->instructions();
     symbol_manager *symmgr = in_sect->symmgr();
     //~ std::list<instruction_t*> const& instructions = parser::singleton().instructions();
     //~ std::list<instruction_t*> instructions;
@@ -91,15 +99,14 @@ namespace hax
     }
 
     std::vector<t_record*> t_records;
-    std::vector<m_record*> m_records;
     //std::vector<d_record*> d_records;
     //std::vector<r_record*> r_records;
 
     instruction_t const* inst = 0;
 
     // TODO: write HEADER record
-    inst = instructions.front();
-    std::string prog_name = inst->label()->token();
+    inst = instructions.instruction_at(0);
+    std::string prog_name(inst->label()->token());
     if (prog_name.size() > 6)
       throw std::runtime_error("program name is too long");
 
@@ -113,21 +120,29 @@ namespace hax
     out << '\n';
     inst = 0;
 
-    // prepare the D and R records
-    // TODO: optimize the symbols fetched here (only get user-defined ones)
+    // prepare the D and R records, the symbol table is ordered by declaration
+    // so the external symbols are sorted by name to keep the records stable
+    std::vector<symbol_t*> externals;
+    for (auto sym : symmgr->symbols())
+      if (sym && (sym->is_external_def() || sym->is_external_ref()))
+        externals.push_back(sym);
+
+    std::sort(externals.begin(), externals.end(), [](symbol_t const* a, symbol_t const* b) {
+      return a->token() < b->token();
+    });
+
     string_t d_record = "D";
     string_t r_record = "R";
     std::ostringstream d_record_str;
     d_record_str << 'D'  << std::uppercase;
-    for (auto entry : symmgr->symbols())
+    for (auto sym : externals)
     {
-      symbol_t *sym = entry.second;
       //~ std::cout << "\tchecking whether symbol '" << sym->token() << "' is an external ref or definition\n";
       if (sym->is_external_def())
       {
         if (DELIMITED_OUTPUT)
           d_record_str << '^';
-        d_record_str << utility::expand(sym->token(), 6, ' ');
+        d_record_str << utility::expand(string_t(sym->token()), 6, ' ');
         if (DELIMITED_OUTPUT)
           d_record_str << '^';
         d_record_str << std::hex << std::setw(6) << std::setfill('0') << sym->address();
@@ -135,7 +150,7 @@ namespace hax
       } else if (sym->is_external_ref()) {
         if (DELIMITED_OUTPUT)
           d_record_str << '^';
-        r_record += utility::expand(sym->token(), 6, ' ');
+        r_record += utility::expand(string_t(sym->token()), 6, ' ');
         std::cout << "found an external reference: " << sym << "\n";
       }
     }
@@ -148,19 +163,20 @@ namespace hax
 
     // prepare T and M records
     t_record *rec = new t_record();
-    rec->address = instructions.front()->location();
+    rec->address = instructions.location(0);
     rec->length = 0x00;
-    for (auto inst : instructions)
+    const size_t count = instructions.size();
+    for (instruction_store::handle_t i = 0; i < count; ++i)
     {
       // skip assembler directives
-      if (!inst->is_assemblable())
+      if (!instructions.has(i, instruction_store::f_assemblable))
       {
         if (VERBOSE)
-        std::cout << "Info: skipping non-assemblable directive '" << inst->mnemonic() << "'\n";
+        std::cout << "Info: skipping non-assemblable directive '" << instructions.instruction_at(i)->mnemonic() << "'\n";
 
         // some assembler directives require us to create a new T record, such as
         // RESB, RESW, USE
-        if (rec && requires_new_trecord(rec, inst)) {
+        if (rec && requires_new_trecord(rec, instructions, i)) {
           t_records.push_back(rec);
           rec = 0;
         }
@@ -168,39 +184,53 @@ namespace hax
         continue;
       }
 
+      const loc_t length = instructions.length(i);
+
+      // data that can not fit in a record of its own fills whatever room is
+      // left in the current record and spills over into the following ones
+      if (length > t_record::maxlen && instructions.has(i, instruction_store::f_data))
+      {
+        for (loc_t offset = 0; offset < length;)
+        {
+          if (!rec || rec->length >= t_record::maxlen)
+          {
+            if (rec)
+              t_records.push_back(rec);
+
+            rec = new t_record();
+            rec->address = instructions.location(i) + offset;
+            rec->length = 0;
+          }
+
+          loc_t piece = std::min<loc_t>(length - offset, t_record::maxlen - rec->length);
+          rec->pieces.push_back({ i, offset, piece });
+          rec->length += piece;
+          offset += piece;
+        }
+
+        std::cout << "t_record[" << t_records.size() + 1 << "] =>: " << instructions.instruction_at(i) << '\n';
+        continue;
+      }
+
       // create a new record if there's none (case1), or if the current one's length
       // has been or will be exceeded (case2)
-      if (!rec || requires_new_trecord(rec, inst))
+      if (!rec || requires_new_trecord(rec, instructions, i))
       {
         if (rec)
           t_records.push_back(rec);
 
         rec = new t_record();
-        rec->address = inst->location();
+        rec->address = instructions.location(i);
         rec->length = 0;
       }
 
-      // does this instruction require an M record for relocation?
-      if (inst->is_relocatable()) {
-        for (auto reloc_rec : inst->reloc_records())
-        {
-          m_record *mrec = new m_record();
-          //~ mrec->location = rec->length + rec->address + 1;
-          mrec->location = inst->location() + (0x06 - reloc_rec->length);
-          mrec->length = reloc_rec->length;
-          mrec->value = reloc_rec->value;
-          //mrec->inst = inst;
-          m_records.push_back(mrec);
-        }
-      }
-
       // step the T record's length by this instruction's length
-      rec->length += inst->length();
+      rec->length += length;
 
-      std::cout << "t_record[" << t_records.size() + 1 << "] =>: " << inst << '\n';
+      std::cout << "t_record[" << t_records.size() + 1 << "] =>: " << instructions.instruction_at(i) << '\n';
 
       // finally, track this instruction and process the next
-      rec->instructions.push_back(inst);
+      rec->pieces.push_back({ i, 0, length });
     }
 
     // track the trailing T record, if any
@@ -224,16 +254,23 @@ namespace hax
       //~ out << std::resetiosflags;
 
       //~ out << std::hex << std::uppercase << std::setw(6) << std::setfill('0');
-      for (auto inst : rec->instructions)
+      for (auto const& piece : rec->pieces)
       {
         if (DELIMITED_OUTPUT)
           out << '^';
-        out << std::setw(inst->length() * 2) << std::setfill('0') << inst->objcode();
+
+        if (instructions.has(piece.instruction, instruction_store::f_data))
+        {
+          byte_span_t bytes = instructions.instruction_at(piece.instruction)->data();
+          utility::write_hex(out, bytes.data + piece.offset, piece.length);
+        }
+        else
+          out << std::setw(piece.length * 2) << std::setfill('0') << instructions.objcode(piece.instruction);
       }
       //~ out << std::resetiosflags;
 
       out << '\n';
-      rec->instructions.clear();
+      rec->pieces.clear();
     }
 
     // clean up the T records
@@ -243,37 +280,38 @@ namespace hax
       t_records.pop_back();
     }
 
-    // write the M records
-    for (m_record *rec : m_records)
+    // write the M records straight from the relocation records of the
+    // assembled instructions
+    for (instruction_store::handle_t i = 0; i < count; ++i)
     {
-      out << std::uppercase << std::hex << std::setfill('0');
-      out << 'M';
+      if (!instructions.has(i, instruction_store::f_assemblable) ||
+          !instructions.has(i, instruction_store::f_relocatable))
+        continue;
 
-      if (DELIMITED_OUTPUT)
-        out << '^';
+      for (auto const& reloc_rec : instructions.instruction_at(i)->reloc_records())
+      {
+        out << std::uppercase << std::hex << std::setfill('0');
+        out << 'M';
 
-      out << std::setw(6) << rec->location;
+        if (DELIMITED_OUTPUT)
+          out << '^';
 
-      if (DELIMITED_OUTPUT)
-        out << '^';
+        out << std::setw(6) << instructions.location(i) + (0x06 - reloc_rec.length);
 
-      out << std::setw(2) << rec->length;
+        if (DELIMITED_OUTPUT)
+          out << '^';
 
-      if (DELIMITED_OUTPUT)
-        out << '^';
+        out << std::setw(2) << (int)reloc_rec.length;
 
-      out << rec->value;
-      out << '\n';
-    }
-    // and clean em up
-    while (!m_records.empty())
-    {
-      delete m_records.back();
-      m_records.pop_back();
+        if (DELIMITED_OUTPUT)
+          out << '^';
+
+        out << (reloc_rec.negative ? '-' : '+') << symmgr->name(reloc_rec.symbol);
+        out << '\n';
+      }
     }
 
     // write the END record
-    inst = instructions.back();
     out << 'E';
     if (in_sect->has_starting_address())
       out << std::hex << std::setw(6) << std::setfill('0') << in_sect->starting_address();
@@ -0,0 +1,67 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "source_reader.hpp"
+#include "readers/mapped_reader.hpp"
+#include "readers/stream_reader.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace hax
+{
+  const size_t source_reader::block_size = 1 << 20;
+
+  source_reader::source_reader(string_t const& in_path)
+  : path_(in_path)
+  {
+  }
+
+  source_reader::~source_reader()
+  {
+  }
+
+  source_reader* source_reader::open(string_t const& in_path)
+  {
+    if (in_path == "-")
+      return new stream_reader(in_path, STDIN_FILENO, false);
+
+    int fd = ::open(in_path.c_str(), O_RDONLY);
+    if (fd == -1)
+      throw std::runtime_error("can not open input file: " + in_path);
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1)
+    {
+      ::close(fd);
+      throw std::runtime_error("can not open input file: " + in_path);
+    }
+
+    if (S_ISREG(st.st_mode))
+      return new mapped_reader(in_path, fd, static_cast<offset_t>(st.st_size));
+
+    return new stream_reader(in_path, fd, true);
+  }
+
+  string_t const& source_reader::path() const
+  {
+    return path_;
+  }
+} // end of namespace
@@ -0,0 +1,136 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "string_interner.hpp"
+#include <cstring>
+
+namespace hax
+{
+  const string_interner::id_t string_interner::nil = 0xFFFFFFFF;
+
+  string_interner::string_interner(arena_t& in_arena)
+  : arena_(in_arena),
+    slots_(64, slot_t { 0, nil, 0, {} }),
+    mask_(63)
+  {
+  }
+
+  string_interner::~string_interner()
+  {
+  }
+
+  uint32_t string_interner::hash(std::string_view in_name)
+  {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (char c : in_name)
+      h = (h ^ static_cast<uint8_t>(c)) * 16777619u;
+
+    return h;
+  }
+
+  size_t string_interner::probe(std::string_view in_name, uint32_t in_hash) const
+  {
+    const size_t length = in_name.size();
+    size_t i = in_hash & mask_;
+    for (;; i = (i + 1) & mask_)
+    {
+      slot_t const& slot = slots_[i];
+      if (slot.id == nil)
+        return i;
+
+      if (slot.hash != in_hash || slot.length != (length > 0xFF ? 0xFF : length))
+        continue;
+
+      if (length <= inline_length)
+      {
+        if (std::memcmp(slot.key, in_name.data(), length) == 0)
+          return i;
+      }
+      else if (names_[slot.id] == in_name)
+        return i;
+    }
+  }
+
+  string_interner::id_t string_interner::find(std::string_view in_name) const
+  {
+    return slots_[probe(in_name, hash(in_name))].id;
+  }
+
+  string_interner::id_t string_interner::intern(std::string_view in_name)
+  {
+    const uint32_t h = hash(in_name);
+    size_t i = probe(in_name, h);
+    if (slots_[i].id != nil)
+      return slots_[i].id;
+
+    // keep the load factor at or below one half
+    if ((names_.size() + 1) * 2 > slots_.size())
+    {
+      grow();
+      i = probe(in_name, h);
+    }
+
+    char* chars = static_cast<char*>(arena_.allocate(in_name.size() + 1, 1));
+    std::memcpy(chars, in_name.data(), in_name.size());
+    chars[in_name.size()] = '\0';
+
+    slot_t& slot = slots_[i];
+    slot.hash = h;
+    slot.id = static_cast<id_t>(names_.size());
+    slot.length = in_name.size() > 0xFF ? 0xFF : static_cast<uint8_t>(in_name.size());
+    if (in_name.size() <= inline_length)
+      std::memcpy(slot.key, in_name.data(), in_name.size());
+
+    names_.push_back(std::string_view(chars, in_name.size()));
+    return slot.id;
+  }
+
+  std::string_view string_interner::name(id_t in_id) const
+  {
+    return names_[in_id];
+  }
+
+  size_t string_interner::size() const
+  {
+    return names_.size();
+  }
+
+  void string_interner::grow()
+  {
+    std::vector<slot_t> slots(slots_.size() * 2, slot_t { 0, nil, 0, {} });
+    const size_t mask = slots.size() - 1;
+
+    for (slot_t const& slot : slots_)
+    {
+      if (slot.id == nil)
+        continue;
+
+      size_t i = slot.hash & mask;
+      while (slots[i].id != nil)
+        i = (i + 1) & mask;
+
+      slots[i] = slot;
+    }
+
+    slots_.swap(slots);
+    mask_ = mask;
+  }
+} // end of namespace
@@ -23,49 +23,111 @@
 #include "instruction.hpp"
 #include "parser.hpp"
 #include "instructions/directive.hpp"
+#include "operands/expression.hpp"
 #include <fstream>
 #include <ostream>
 #include <exception>
 #include <stdexcept>
+#include <algorithm>
 
 namespace hax
 {
   extern bool VERBOSE;
 	//~ symbol_manager* symbol_manager::__instance = 0;
 
+  const symbol_id_t symbol_manager::builtin_base = 0xFFFFFF00;
+
+  /* the order of the built-in symbols in the shared table */
+  enum builtin_index_t {
+    b_zero = 0,
+    b_a, b_x, b_l, b_b, b_s, b_t, b_f, b_pc, b_sw,
+    b_current_loc
+  };
+
+  symbol_manager::builtins_t const& symbol_manager::builtins()
+  {
+    static builtins_t const table = []() {
+      builtins_t symbols;
+      symbols.reserve(b_current_loc + 1);
+
+      auto add = [&](std::string_view in_name, loc_t in_loc, bool value_and_address) {
+        symbols.emplace_back(in_name, builtin_base + symbols.size());
+        symbols.back().assign_address(in_loc);
+        if (value_and_address)
+          symbols.back()._assign_value(in_loc);
+      };
+
+      // special symbol for internal usage:
+      // format3/4 instructions that require no arguments (like RSUB) are assigned
+      // "0" as their operand, hence we define
+      // "0" as an actual symbol that points to address 0x0000, in the spirit of
+      // keeping a uniform interface for all format3/4 instructions
+      add("0", 0, true);
+
+      // SIC/XE registers
+      add("A",  0x00, true);
+      add("X",  0x01, true);
+      add("L",  0x02, true);
+      add("B",  0x03, true);
+      add("S",  0x04, true);
+      add("T",  0x05, true);
+      add("F",  0x06, true);
+      add("PC", 0x08, true);
+      add("SW", 0x09, true);
+
+      add("*", 0x0, false);
+      return symbols;
+    }();
+
+    return table;
+  }
+
+  symbol_t *const symbol_manager::builtin(std::string_view in_name)
+  {
+    int index = -1;
+    if (in_name.size() == 1)
+    {
+      switch (in_name[0])
+      {
+        case '0': index = b_zero; break;
+        case 'A': index = b_a; break;
+        case 'X': index = b_x; break;
+        case 'L': index = b_l; break;
+        case 'B': index = b_b; break;
+        case 'S': index = b_s; break;
+        case 'T': index = b_t; break;
+        case 'F': index = b_f; break;
+        case '*': index = b_current_loc; break;
+      }
+    }
+    else if (in_name == "PC")
+      index = b_pc;
+    else if (in_name == "SW")
+      index = b_sw;
+
+    if (index == -1)
+      return 0;
+
+    // the table is immutable, its symbols are handed out as plain operands
+    return const_cast<symbol_t*>(&builtins()[index]);
+  }
+
+  bool symbol_manager::is_builtin(symbol_id_t in_id)
+  {
+    return in_id >= builtin_base && in_id - builtin_base <= b_current_loc;
+  }
+
 	symbol_manager::symbol_manager(control_section* in_sect)
-  : sect_(in_sect)
-  {
-
-    // special symbol for internal usage:
-    // format3/4 instructions that require no arguments (like RSUB) are assigned
-    // "0" as their operand, hence we define
-    // "0" as an actual symbol that points to address 0x0000, in the spirit of
-    // keeping a uniform interface for all format3/4 instructions
-    define(declare("0"), 0, true);
-
-    // SIC/XE registers
-    define(declare("A"),  0x00, true);
-    define(declare("X"),  0x01, true);
-    define(declare("L"),  0x02, true);
-    define(declare("B"),  0x03, true);
-    define(declare("S"),  0x04, true);
-    define(declare("T"),  0x05, true);
-    define(declare("F"),  0x06, true);
-    define(declare("PC"), 0x08, true);
-    define(declare("SW"), 0x09, true);
-
-    define(declare("*"), 0x0, false);
+  : sect_(in_sect),
+    names_(in_sect->arena()),
+    epoch_(0)
+  {
 	}
 
 	symbol_manager::~symbol_manager()
 	{
+    // symbols and literals are released by the arena of the section
     literals_.clear();
-
-    for (auto entry : symbols_)
-    {
-      delete entry.second;
-    }
     symbols_.clear();
 
     sect_ = 0;
@@ -81,14 +143,19 @@ namespace hax
 		return *singleton_ptr();
 	}*/
 
-  symbol_t *const symbol_manager::declare(string_t const& in_symbol)
+  symbol_t *const symbol_manager::declare(std::string_view in_symbol)
   {
-    symbols_t::const_iterator finder = symbols_.find(in_symbol);
-    if (finder != symbols_.end())
-      return finder->second;
+    if (symbol_t* sym = builtin(in_symbol))
+      return sym;
 
-    symbol_t *sym = new symbol_t(in_symbol);
-    symbols_.insert(std::make_pair(in_symbol, sym));
+    symbol_id_t id = names_.intern(in_symbol);
+    if (id == symbols_.size())
+      symbols_.push_back(0);
+    else if (symbols_[id])
+      return symbols_[id];
+
+    symbol_t *sym = sect_->arena().create<symbol_t>(names_.name(id), id);
+    symbols_[id] = sym;
     return sym;
   }
 
@@ -101,21 +168,40 @@ namespace hax
     return in_symbol;
   }
 
-  symbol_t *const symbol_manager::lookup(string_t const& in_label) const
+  symbol_t *const symbol_manager::lookup(std::string_view in_label) const
   {
-    symbols_t::const_iterator entry = symbols_.find(in_label);
-    if (entry == symbols_.end())
+    if (symbol_t* sym = builtin(in_label))
+      return sym;
+
+    symbol_id_t id = names_.find(in_label);
+    if (id == string_interner::nil)
       return 0;
 
-    return entry->second;
+    return symbols_[id];
+  }
+
+  symbol_t *const symbol_manager::lookup(symbol_id_t in_id) const
+  {
+    if (is_builtin(in_id))
+      return const_cast<symbol_t*>(&builtins()[in_id - builtin_base]);
+
+    return in_id < symbols_.size() ? symbols_[in_id] : 0;
+  }
+
+  std::string_view symbol_manager::name(symbol_id_t in_id) const
+  {
+    if (is_builtin(in_id))
+      return builtins()[in_id - builtin_base].token();
+
+    return names_.name(in_id);
   }
 
-  bool symbol_manager::is_declared(string_t const& in_name) const
+  bool symbol_manager::is_declared(std::string_view in_name) const
   {
-    return symbols_.find(in_name) != symbols_.end();
+    return lookup(in_name) != 0;
   }
 
-  bool symbol_manager::is_defined(string_t const& in_name) const
+  bool symbol_manager::is_defined(std::string_view in_name) const
   {
     symbol_t *const sym = lookup(in_name);
     if (!sym)
@@ -126,11 +212,11 @@ namespace hax
 
   void symbol_manager::dump(std::ostream& out) const
   {
-    out << "+- Listing " << symbols_.size() << " symbols:\n";
+    std::vector<symbol_t*> symbols = sorted_symbols();
+    out << "+- Listing " << symbols.size() << " symbols:\n";
     int i=0;
-    for (auto entry : symbols_)
+    for (auto symbol : symbols)
     {
-      symbol_t *symbol = entry.second;
       out << std::uppercase
       << "  " << ++i << ". "
       << symbol->token() << "\t"
@@ -145,16 +231,177 @@ namespace hax
     return symbols_;
   }
 
-  void symbol_manager::__undefine(string_t const& in_sym)
+  std::vector<symbol_t*> symbol_manager::sorted_symbols() const
+  {
+    std::vector<symbol_t*> symbols;
+    symbols.reserve(symbols_.size());
+    for (auto sym : symbols_)
+      if (sym)
+        symbols.push_back(sym);
+
+    std::sort(symbols.begin(), symbols.end(), [](symbol_t const* a, symbol_t const* b) {
+      return a->token() < b->token();
+    });
+
+    return symbols;
+  }
+
+  void symbol_manager::__undefine(std::string_view in_sym)
   {
-    symbol_t *sym = lookup(in_sym);
-    if (sym) {
-      //~ delete sym;
-      symbols_.erase(in_sym);
+    // the name stays interned, so the symbol keeps its id if it is declared again
+    symbol_id_t id = names_.find(in_sym);
+    if (id != string_interner::nil)
+    {
+      symbols_[id] = 0;
+      __advance_epoch();
     }
   }
 
-  instruction* symbol_manager::declare_literal(string_t const& in_value, operand* in_dep)
+  uint32_t symbol_manager::epoch() const
+  {
+    return epoch_;
+  }
+
+  void symbol_manager::__advance_epoch()
+  {
+    ++epoch_;
+  }
+
+  void symbol_manager::defer_definition(directive* in_equ)
+  {
+    deferred_.push_back(in_equ);
+  }
+
+  void symbol_manager::resolve_definitions()
+  {
+    const uint32_t none = 0xFFFFFFFF;
+    const size_t count = deferred_.size();
+
+    enum : uint8_t { s_pending, s_visiting, s_defined, s_failed };
+    std::vector<uint8_t> state(count, s_pending);
+
+    // the deferred definitions are the nodes of the graph, looked up by the
+    // id of the symbol they define
+    std::vector<uint32_t> node_of(symbols_.size(), none);
+    for (size_t n = 0; n < count; ++n)
+    {
+      symbol_t const* label = deferred_[n]->label();
+      if (is_builtin(label->id()) || node_of[label->id()] != none || label->is_evaluated())
+      {
+        symbol_redifinition e("token '" + string_t(label->token()) + "'", deferred_[n]->line());
+        parser::singleton().track_error(e);
+        state[n] = s_failed;
+        continue;
+      }
+
+      node_of[label->id()] = n;
+    }
+
+    // and the symbols their operands refer to are their edges, laid out flat
+    std::vector<size_t> first_edge(count + 1);
+    std::vector<symbol_t*> edges;
+    for (size_t n = 0; n < count; ++n)
+    {
+      first_edge[n] = edges.size();
+
+      operand* op = deferred_[n]->get_operand();
+      if (op->is_symbol())
+        edges.push_back(static_cast<symbol_t*>(op));
+      else if (op->is_expression())
+        for (auto sym : static_cast<expression*>(op)->references())
+          edges.push_back(sym);
+    }
+    first_edge[count] = edges.size();
+
+    // every stack frame holds a node and the next of its edges to follow
+    std::vector<std::pair<size_t, size_t>> stack;
+    for (size_t root = 0; root < count; ++root)
+    {
+      if (state[root] != s_pending)
+        continue;
+
+      state[root] = s_visiting;
+      stack.push_back(std::make_pair(root, first_edge[root]));
+
+      while (!stack.empty())
+      {
+        size_t node = stack.back().first;
+        size_t edge = stack.back().second;
+
+        if (state[node] == s_visiting && edge < first_edge[node + 1])
+        {
+          ++stack.back().second;
+
+          symbol_t* dep = edges[edge];
+          uint32_t target = is_builtin(dep->id()) ? none : node_of[dep->id()];
+          if (target == none)
+          {
+            if (!dep->is_evaluated())
+            {
+              invalid_operand e("EQU operand refers to '" + string_t(dep->token()) + "' which is never defined",
+                                deferred_[node]->line());
+              parser::singleton().track_error(e);
+              state[node] = s_failed;
+            }
+            continue;
+          }
+
+          switch (state[target])
+          {
+            case s_pending:
+              state[target] = s_visiting;
+              stack.push_back(std::make_pair(size_t(target), first_edge[target]));
+              break;
+
+            case s_visiting:
+            {
+              // the target is on the stack, and so is every definition between
+              // it and this one
+              size_t from = stack.size() - 1;
+              while (stack[from].first != target)
+                --from;
+
+              string_t cycle;
+              for (size_t i = from; i < stack.size(); ++i)
+              {
+                cycle += string_t(deferred_[stack[i].first]->label()->token()) + " -> ";
+                state[stack[i].first] = s_failed;
+              }
+              cycle += string_t(deferred_[target]->label()->token());
+
+              circular_definition e(cycle, deferred_[target]->line());
+              parser::singleton().track_error(e);
+              break;
+            }
+
+            case s_failed:
+              state[node] = s_failed;
+              break;
+
+            default:
+              break;
+          }
+          continue;
+        }
+
+        // every dependency of the node is defined by now, unless one failed
+        stack.pop_back();
+        if (state[node] == s_visiting)
+        {
+          state[node] = parser::singleton().track_error(deferred_[node]->__define())
+            ? s_defined
+            : s_failed;
+        }
+
+        if (state[node] == s_failed && !stack.empty())
+          state[stack.back().first] = s_failed;
+      }
+    }
+
+    deferred_.clear();
+  }
+
+  instruction* symbol_manager::declare_literal(std::string_view in_value, operand* in_dep)
   {
     // if this literal has been declared in this pool before, do nothing
     literals_t::iterator finder = literals_.find(in_value);
@@ -164,7 +411,7 @@ namespace hax
     }
 
 
-    literal* lit = new literal(in_value, sect_->block());
+    literal* lit = sect_->arena().create<literal>(in_value, sect_->block());
     lit->add_dependency(in_dep);
     //literal->assign_label(lookup("*"));
     //~ operand* oper = new constant(in_value);
@@ -176,7 +423,7 @@ namespace hax
     return lit;
   }
 
-  void symbol_manager::dump_literal_pool(bool do_step)
+  status_t symbol_manager::dump_literal_pool(bool do_step)
   {
     program_block* block = sect_->block();
 
@@ -190,23 +437,34 @@ namespace hax
         continue;
 
       block->add_instruction(lit);
-      lit->assign_operand(entry.first);
-      lit->preprocess();
+
+      status_t result = lit->assign_operand(entry.first, 0);
+      if (!result.ok())
+        return result;
+
+      result = lit->preprocess();
+      if (!result.ok())
+        return result;
 
       if (VERBOSE)
         std::cout << "Literal : " << lit << "\n";
 
       //~ do_step = !lit->is_assembled();
-      lit->assemble();
+      result = lit->assemble();
+      if (!result.ok())
+        return result;
 
       //~ if (do_step)
-        block->step();
+      result = block->step();
+      if (!result.ok())
+        return result;
     }
     std::cout << "-- Literal pool created\n";
     //~ literals_.clear();
+    return status_t();
   }
 
-  instruction* symbol_manager::lookup_literal(string_t const& in_value)
+  instruction* symbol_manager::lookup_literal(std::string_view in_value)
   {
     literals_t::iterator finder = literals_.find(in_value);
     if (finder != literals_.end())
@@ -218,6 +476,6 @@ namespace hax
     for (auto entry : literals_)
       std::cout << "\t" << entry.first << " => " << entry.second << "\n";
 
-    throw internal_error("unable to find literal with value: " + in_value, "literal table corruption");
+    throw internal_error("unable to find literal with value: " + string_t(in_value), "literal table corruption");
   }
 } // end of namespace
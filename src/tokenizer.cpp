@@ -0,0 +1,101 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tokenizer.hpp"
+#include <cstring>
+
+namespace hax
+{
+  static_assert(int(entry_t::max_fields) == int(scanned_line_t::max_fields),
+    "every field tracked by the line scanner must have a role in an entry");
+
+  status_t tokenizer::tokenize(const char* in_block, scanned_line_t const& in_line, entry_t& out_entry)
+  {
+    out_entry = entry_t();
+    out_entry.line = std::string_view(in_block + in_line.begin, in_line.end - in_line.begin);
+
+    if (in_line.nr_fields > scanned_line_t::max_fields)
+      return status_t::failure(invalid_entry("unexpected fields past the operand", string_t(out_entry.line)));
+
+    std::string_view fields[scanned_line_t::max_fields];
+    for (uint32_t i = 0; i < in_line.nr_fields; ++i)
+      fields[i] = std::string_view(in_block + in_line.fields[i].begin,
+                                   in_line.fields[i].end - in_line.fields[i].begin);
+
+    // find out whether the first field is a label or an opcode
+    int field = 0;
+    out_entry.op = lookup(fields[0]);
+    if (!out_entry.op)
+    {
+      out_entry.fields[entry_t::r_label] = fields[field++];
+      out_entry.op = lookup(fields[field]);
+    }
+    else if (in_line.nr_fields == scanned_line_t::max_fields)
+      return status_t::failure(invalid_entry("unexpected field '" + string_t(fields[2]) + "'", string_t(out_entry.line)));
+
+    out_entry.fields[entry_t::r_mnemonic] = fields[field++];
+    out_entry.fields[entry_t::r_operand] = fields[field];
+
+    if (!out_entry.mnemonic().empty() && out_entry.mnemonic().front() == '+')
+      out_entry.flags |= entry_t::f_extended;
+
+    out_entry.flags |= operand_flags(out_entry.operand());
+    return status_t();
+  }
+
+  const op_t* tokenizer::lookup(std::string_view in_mnemonic)
+  {
+    if (!in_mnemonic.empty() && in_mnemonic.front() == '+')
+      in_mnemonic.remove_prefix(1);
+
+    return optable::find(in_mnemonic);
+  }
+
+  uint8_t tokenizer::operand_flags(std::string_view in_operand)
+  {
+    uint8_t flags = 0;
+    if (in_operand.empty())
+      return flags;
+
+    if (in_operand.front() == '#')
+      flags |= entry_t::f_immediate;
+    else if (in_operand.front() == '@')
+      flags |= entry_t::f_indirect;
+
+    size_t len = in_operand.size();
+    if (len >= 2 && in_operand[len-2] == ',' && in_operand[len-1] == 'X')
+      flags |= entry_t::f_indexed;
+
+    return flags;
+  }
+
+  void tokenizer::copy_into(arena_t& in_arena, entry_t& io_entry)
+  {
+    char* copy = static_cast<char*>(in_arena.allocate(io_entry.line.size(), 1));
+    std::memcpy(copy, io_entry.line.data(), io_entry.line.size());
+
+    // every field lies within the line, missing fields stay empty
+    for (std::string_view& field : io_entry.fields)
+      if (!field.empty())
+        field = std::string_view(copy + (field.data() - io_entry.line.data()), field.size());
+
+    io_entry.line = std::string_view(copy, io_entry.line.size());
+  }
+} // end of namespace
@@ -0,0 +1,64 @@
+# assembles programs at and past the 20-bit SIC/XE address space
+#
+# near_limit:       a section just short of 1 MiB whose last word is reached
+#                   through format 4 instructions
+# resw_overflow:    a RESW count that would wrap a 32-bit location counter
+# blocks_overflow:  program blocks that fit on their own but not laid out
+#                   together; no object program may be written for it
+# fmt4_overflow:    a format 4 immediate wider than the 20-bit address field
+
+SET(asm "${WORK_DIR}/${CASE}.asm")
+SET(obj "${WORK_DIR}/${CASE}.obj")
+
+IF(CASE STREQUAL "near_limit")
+  FILE(WRITE ${asm}
+"BIG     START   0
+FIRST   +LDA    TAIL
+        +STA    BUFFER
+        RSUB
+BUFFER  RESB    1048000
+        RESW    10
+TAIL    WORD    5
+        END     FIRST
+")
+  SET(expected_obj
+"HBIG   0000000FFDEC
+T0000000B031FFDE90F10000B4F0000
+T0FFDE903000005
+E000000
+")
+ELSEIF(CASE STREQUAL "resw_overflow")
+  FILE(WRITE ${asm}
+"WRAP    START   0
+FIRST   LDA     TAIL
+        RESW    1431655766
+TAIL    WORD    1
+        END     FIRST
+")
+  SET(expected_error "RESW reserves more than the 20-bit address space")
+ELSEIF(CASE STREQUAL "blocks_overflow")
+  FILE(WRITE ${asm}
+"SPLIT   START   0
+FIRST   LDA     TAIL
+        USE     DATA
+        RESB    700000
+        USE
+        RESB    700000
+TAIL    WORD    1
+        END     FIRST
+")
+  SET(expected_error "past the 20-bit address space")
+ELSEIF(CASE STREQUAL "fmt4_overflow")
+  FILE(WRITE ${asm}
+"WIDE    START   0
+FIRST   +LDA    #1048575
+        +LDA    #2000000
+        END     FIRST
+")
+  SET(expected_error "target out of bounds': 2000000")
+  SET(expected_nr_errors 1)
+ELSE()
+  MESSAGE(FATAL_ERROR "unknown case: ${CASE}")
+ENDIF()
+
+INCLUDE(${CMAKE_CURRENT_LIST_DIR}/run_case.cmake)
@@ -0,0 +1,223 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * differential test of the format 3 encoders: the scalar and SSE2 batch
+ * encoders, and fmt3_batch itself, must produce exactly what the reference
+ * encoders picked by encoding::select_fmt3() do
+ *
+ * the operands sit on and around the edges of every targeting mode and are
+ * encoded in batches of every length up to 4 lanes past a multiple of 4, so
+ * that each edge lands in every SSE2 lane as well as in the scalar tail
+ *
+ * usage: encoders_test
+ **/
+
+#include "encoders.hpp"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace hax;
+using namespace hax::encoding;
+
+namespace {
+
+  int failures = 0;
+
+  struct operand_t {
+    opcode_t opcode;
+    uint32_t mode;
+    bool indexed;
+    bool absolute;
+    int target;
+    int pc;
+    int base;
+  };
+
+  std::string describe(operand_t const& in_op)
+  {
+    return "opcode " + std::to_string(in_op.opcode)
+      + ", mode " + std::to_string(in_op.mode >> 16)
+      + (in_op.indexed ? ", indexed" : "")
+      + (in_op.absolute ? ", absolute" : "")
+      + ", target " + std::to_string(in_op.target)
+      + ", pc " + std::to_string(in_op.pc)
+      + ", base " + std::to_string(in_op.base);
+  }
+
+  objcode_t reference(operand_t const& in_op)
+  {
+    encoder_t encoder = select_fmt3(in_op.mode, in_op.indexed, in_op.absolute);
+    return encoder(in_op.opcode, in_op.target, in_op.pc, in_op.base);
+  }
+
+  /* encodes in_ops[in_first, in_first + in_count) every way and compares */
+  void check(std::string const& in_name, std::vector<operand_t> const& in_ops, size_t in_first, size_t in_count)
+  {
+    std::vector<objcode_t> heads;
+    std::vector<uint32_t> absolute;
+    std::vector<int32_t> targets, pcs, bases;
+    fmt3_batch batch;
+
+    for (size_t i = in_first; i < in_first + in_count; ++i)
+    {
+      operand_t const& op = in_ops[i];
+      heads.push_back(fmt3_batch::head(op.opcode, op.mode, op.indexed));
+      absolute.push_back(op.absolute ? 0xFFFFFFFF : 0);
+      targets.push_back(op.target);
+      pcs.push_back(op.pc);
+      bases.push_back(op.base);
+      batch.add(nullptr, op.opcode, op.mode, op.indexed, op.absolute, op.target, op.pc, op.base);
+    }
+
+    // one spare entry so that empty batches still have valid pointers
+    heads.push_back(0); absolute.push_back(0); targets.push_back(0); pcs.push_back(0); bases.push_back(0);
+
+    std::vector<objcode_t> scalar(in_count + 1), sse2(in_count + 1);
+    fmt3_batch::encode_scalar(&heads[0], &absolute[0], &targets[0], &pcs[0], &bases[0], &scalar[0], in_count);
+    fmt3_batch::encode_sse2(&heads[0], &absolute[0], &targets[0], &pcs[0], &bases[0], &sse2[0], in_count);
+    batch.encode();
+
+    for (size_t i = 0; i < in_count; ++i)
+    {
+      objcode_t expected = reference(in_ops[in_first + i]);
+      if (scalar[i] != expected || sse2[i] != expected || batch.objcode_at(i) != expected)
+      {
+        std::cerr
+          << "mismatch in " << in_name << " at " << in_first + i << " of a batch of " << in_count
+          << " (" << describe(in_ops[in_first + i]) << "): expected " << std::hex << expected
+          << ", scalar " << scalar[i] << ", SSE2 " << sse2[i] << ", batch " << batch.objcode_at(i)
+          << std::dec << "\n";
+        ++failures;
+        return;
+      }
+    }
+  }
+
+  /* every batch length up to and past a multiple of 4, at every offset */
+  void check_all(std::string const& in_name, std::vector<operand_t> const& in_ops)
+  {
+    for (size_t first = 0; first < 4 && first <= in_ops.size(); ++first)
+      for (size_t count = 0; first + count <= in_ops.size(); ++count)
+        check(in_name, in_ops, first, count);
+  }
+
+  /* pins down a few encodings so the reference itself is kept honest */
+  void expect(std::string const& in_name, operand_t const& in_op, objcode_t in_objcode)
+  {
+    if (reference(in_op) != in_objcode)
+    {
+      std::cerr
+        << in_name << " (" << describe(in_op) << "): expected " << std::hex << in_objcode
+        << ", got " << reference(in_op) << std::dec << "\n";
+      ++failures;
+    }
+  }
+
+  void check_expected()
+  {
+    const uint32_t simple = instruction::simple, immediate = instruction::immediate;
+
+    expect("last PC-relative displacement", { 0x00, simple, false, false, 2047 + 100, 100, 0 }, 0x032000 | 0x7FF);
+    expect("first PC-relative displacement", { 0x00, simple, false, false, 100 - 2048, 100, 0 }, 0x032000 | 0x800);
+    expect("last base-relative displacement", { 0x00, simple, true, false, 9000 + 4095, 9000 - 2048, 9000 }, 0x03C000 | 0xFFF);
+    expect("direct target", { 0x00, simple, false, false, 4095, 9000, 8000 }, 0x030FFF);
+    expect("unreachable target", { 0x00, simple, false, false, 4096, 9000, 8000 }, out_of_bounds);
+    expect("largest constant", { 0x00, immediate, false, true, 4095, 4095, 4095 }, 0x010FFF);
+    expect("constant too large", { 0x00, immediate, false, true, 4096, 4096, 0 }, out_of_bounds);
+    expect("negative constant", { 0x00, immediate, false, true, -1, -1, -1 }, out_of_bounds);
+  }
+
+  /* operands on either side of the edges of each targeting mode */
+  void check_edges()
+  {
+    const uint32_t modes[] = { instruction::simple, instruction::indirect, instruction::immediate };
+    const int pc_disps[] = { -2049, -2048, -2047, -1, 0, 1, 2046, 2047, 2048, 2049 };
+    const int base_disps[] = { -2, -1, 0, 1, 4094, 4095, 4096, 4097 };
+    const int targets[] = { -1, 0, 1, 4094, 4095, 4096, 4097, 0xFFFFF };
+
+    std::vector<operand_t> ops;
+    opcode_t opcode = 0;
+    for (uint32_t mode : modes)
+      for (int indexed = 0; indexed < 2; ++indexed)
+      {
+        opcode = (opcode + 4) & 0xFC;
+
+        // PC-relative, far away from the base and the first 4096 bytes
+        for (int disp : pc_disps)
+          ops.push_back({ opcode, mode, bool(indexed), false, 50000 + disp, 50000, 0 });
+
+        // base-relative, out of PC range
+        for (int disp : base_disps)
+          ops.push_back({ opcode, mode, bool(indexed), false, 50000 + disp, 90000, 50000 });
+
+        // direct, out of PC and base range
+        for (int target : targets)
+          ops.push_back({ opcode, mode, bool(indexed), false, target, 90000, 60000 });
+
+        // constants, which must never be encoded relatively even when they
+        // would be in range
+        for (int target : targets)
+          ops.push_back({ opcode, mode, bool(indexed), true, target, target, target });
+        for (int disp : pc_disps)
+          ops.push_back({ opcode, mode, bool(indexed), true, 5000 + disp, 5000, 5000 });
+      }
+
+    check_all("edges", ops);
+  }
+
+  /* operands with targets, PCs and bases close enough to hit every mode */
+  void check_random()
+  {
+    const uint32_t modes[] = { instruction::simple, instruction::indirect, instruction::immediate };
+    std::mt19937 rng(0x5ca9);
+    std::uniform_int_distribution<int> location(0, 0x2000);
+    std::uniform_int_distribution<int> offset(-5000, 5000);
+    std::uniform_int_distribution<int> pick(0, 255);
+
+    std::vector<operand_t> ops;
+    for (int i = 0; i < 4000; ++i)
+    {
+      int bits = pick(rng);
+      int pc = location(rng);
+      ops.push_back({
+        opcode_t(pick(rng) & 0xFC), modes[bits % 3], bool(bits & 0x8), (bits & 0x70) == 0,
+        pc + offset(rng), pc, location(rng) });
+    }
+
+    for (size_t count = 0; count <= 67; ++count)
+      check("random", ops, ops.size() - count, count);
+    check("random", ops, 0, ops.size());
+    check("random", ops, 1, ops.size() - 1);
+  }
+}
+
+int main()
+{
+  check_expected();
+  check_edges();
+  check_random();
+
+  std::cout << "compared the scalar, SSE2 and batch format 3 encoders: " << failures << " mismatches\n";
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,49 @@
+# breaks source lines into entries
+#
+# quoted_operands:    spaces and comment markers inside C'' constants and
+#                     literals belong to the operand
+# malformed_entries:  entries with too many fields are reported like any
+#                     other error instead of aborting the assembler
+# constant_errors:    a malformed constant is reported with the line that
+#                     uses it, even though constants are shared
+
+SET(asm "${WORK_DIR}/${CASE}.asm")
+SET(obj "${WORK_DIR}/${CASE}.obj")
+
+IF(CASE STREQUAL "quoted_operands")
+  FILE(WRITE ${asm}
+"MSG     START   0
+FIRST   LDA     LEN
+MSG1    BYTE    C'HELLO WORLD'
+MSG2    BYTE    C'A.B;C'   . trailing comment
+        LDA     =C'X Y'
+LEN     WORD    3
+        LTORG
+        END     FIRST
+")
+  SET(expected_obj
+"HMSG   00000000001C
+T0000001C03201348454C4C4F20574F524C44412E423B43032003000003582059
+E000000
+")
+ELSEIF(CASE STREQUAL "malformed_entries")
+  FILE(WRITE ${asm}
+"BAD     START   0
+FIRST   LDA     LEN EXTRA
+        LDA     LEN
+LEN     WORD    3
+        END     FIRST
+")
+  SET(expected_error "unexpected fields past the operand")
+ELSEIF(CASE STREQUAL "constant_errors")
+  FILE(WRITE ${asm}
+"BAD     START   0
+FIRST   LDA     #X'ZZ'
+        END     FIRST
+")
+  SET(expected_error "(in \"FIRST   LDA     #X'ZZ'\")")
+ELSE()
+  MESSAGE(FATAL_ERROR "unknown case: ${CASE}")
+ENDIF()
+
+INCLUDE(${CMAKE_CURRENT_LIST_DIR}/run_case.cmake)
@@ -0,0 +1,24 @@
+# reports the errors found in a program
+#
+# reported_once:  every error of every control section is reported exactly
+#                 once, after all the sections were assembled
+
+SET(asm "${WORK_DIR}/${CASE}.asm")
+SET(obj "${WORK_DIR}/${CASE}.obj")
+
+IF(CASE STREQUAL "reported_once")
+  FILE(WRITE ${asm}
+"FIRST   START   0
+ONE     LDA     5000
+        +LDA    @3
+        END     ONE
+SECOND  CSECT
+TWO     LDA     6000
+")
+  SET(expected_error "target out of bounds")
+  SET(expected_nr_errors 3)
+ELSE()
+  MESSAGE(FATAL_ERROR "unknown case: ${CASE}")
+ENDIF()
+
+INCLUDE(${CMAKE_CURRENT_LIST_DIR}/run_case.cmake)
@@ -0,0 +1,160 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * differential test of the hex decoder: payloads long enough to take the
+ * SSE2 path must decode to exactly the bytes the scalar decoder gives, and
+ * malformed ones must be rejected by both
+ *
+ * every byte value is placed at every digit position of payloads that span
+ * one to several 16-byte vectors, with an even and an odd number of digits,
+ * so that each invalid character is seen in every lane as well as in the
+ * scalar tail
+ *
+ * usage: hex_decoder_test
+ **/
+
+#include "hex_decoder.hpp"
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using hax::hex_decoder;
+
+namespace {
+
+  int failures = 0;
+
+  const char digits[] = "0123456789abcdefABCDEF";
+
+  bool is_hex(char c)
+  {
+    return c != '\0' && std::strchr(digits, c) != nullptr;
+  }
+
+  std::string printable(std::string const& in_hex)
+  {
+    std::string out;
+    for (unsigned char c : in_hex)
+      out += (c >= 0x20 && c < 0x7F) ? std::string(1, c) : "\\x" + std::to_string(c);
+    return out;
+  }
+
+  /* decodes in_hex every way and compares with the scalar decoder */
+  void check(std::string const& in_name, std::string const& in_hex)
+  {
+    bool valid = true;
+    for (char c : in_hex)
+      valid = valid && is_hex(c);
+
+    // the scalar decoder is the reference, an odd digit count is read as if
+    // prefixed with a 0
+    std::string padded = (in_hex.size() % 2 ? "0" : "") + in_hex;
+    size_t count = padded.size() / 2;
+    std::vector<uint8_t> scalar(count + 1), sse2(count + 1), decoded;
+    bool scalar_valid = hex_decoder::decode_pairs_scalar(padded.data(), scalar.data(), count);
+    bool sse2_valid = hex_decoder::decode_pairs_sse2(padded.data(), sse2.data(), count);
+    bool decode_valid = hex_decoder::decode(in_hex, decoded);
+
+    const char* error = nullptr;
+    if (scalar_valid != valid)
+      error = valid ? "scalar rejected valid hex" : "scalar accepted malformed hex";
+    else if (sse2_valid != valid)
+      error = valid ? "SSE2 rejected valid hex" : "SSE2 accepted malformed hex";
+    else if (decode_valid != valid)
+      error = valid ? "decode() rejected valid hex" : "decode() accepted malformed hex";
+    else if (valid && std::memcmp(scalar.data(), sse2.data(), count) != 0)
+      error = "SSE2 bytes differ from the scalar ones";
+    else if (valid && (decoded.size() != count || std::memcmp(scalar.data(), decoded.data(), count) != 0))
+      error = "decode() bytes differ from the scalar ones";
+
+    if (error)
+    {
+      std::cerr << in_name << ": " << error << " in '" << printable(in_hex) << "'\n";
+      ++failures;
+    }
+  }
+
+  /* every byte value at every position of payloads of 16 pairs and more */
+  void check_invalid()
+  {
+    const size_t lengths[] = { 32, 33, 34, 47, 48, 49, 63, 64, 65 };
+
+    for (size_t length : lengths)
+    {
+      std::string hex(length, '0');
+      for (size_t i = 0; i < length; ++i)
+        hex[i] = digits[i % (sizeof(digits) - 1)];
+
+      for (size_t at = 0; at < length; ++at)
+        for (int c = 0; c < 256; ++c)
+        {
+          std::string bad = hex;
+          bad[at] = char(c);
+          check("byte " + std::to_string(c) + " at " + std::to_string(at) + " of " + std::to_string(length), bad);
+        }
+    }
+  }
+
+  /* the characters right outside the digit and letter ranges, alone and
+   * next to their valid neighbours */
+  void check_neighbours()
+  {
+    const char outside[] = { '/', ':', '@', 'G', '`', 'g', '\x80', '\xB0', '\xC1', '\xE1', '\xFF', ' ', '\0' };
+
+    for (char c : outside)
+      for (size_t at = 0; at < 40; ++at)
+      {
+        std::string hex = "9aAfF0" "09afAF" "fedcbaFEDCBA" "0123456789" "abcdefABCDEF";
+        hex[at] = c;
+        check("neighbour " + std::to_string(int(c)) + " at " + std::to_string(at), hex);
+      }
+  }
+
+  /* valid payloads of mixed case and of every length around the threshold */
+  void check_random()
+  {
+    std::mt19937 rng(0x5ca9);
+    std::uniform_int_distribution<size_t> pick(0, sizeof(digits) - 2);
+
+    for (size_t length = 0; length < 300; ++length)
+      for (int i = 0; i < 8; ++i)
+      {
+        std::string hex(length, '0');
+        for (char& c : hex)
+          c = digits[pick(rng)];
+
+        check("random payload of " + std::to_string(length), hex);
+      }
+  }
+}
+
+int main()
+{
+  check_invalid();
+  check_neighbours();
+  check_random();
+
+  std::cout << "compared the scalar and SSE2 hex decoders: " << failures << " mismatches\n";
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,155 @@
+/*
+ *  This file is part of Hax.
+ *
+ *  HASM - an assembler for the open-source language Hax
+ *  Copyright (C) 2011  Ahmad Amireh <ahmad@amireh.net>
+ *
+ *  HASM is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  HASM is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with HASM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * differential test of the line scanner: the SSE2 and AVX2 scanners must find
+ * exactly the lines and fields the scalar one does
+ *
+ * every input is scanned at each of 64 alignments so that its lines start,
+ * end and get split at every position of the 16, 32 and 64-byte chunks the
+ * vectorized scanners work on
+ *
+ * usage: line_scanner_test FIXTURE...
+ **/
+
+#include "line_scanner.hpp"
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+using hax::line_scanner;
+using hax::scanned_line_t;
+
+namespace {
+
+  int failures = 0;
+
+  bool same(line_scanner::lines_t const& lhs, line_scanner::lines_t const& rhs)
+  {
+    if (lhs.size() != rhs.size())
+      return false;
+
+    for (size_t i = 0; i < lhs.size(); ++i)
+      if (!(lhs[i] == rhs[i]))
+        return false;
+
+    return true;
+  }
+
+  /* compares the scanners on in_input placed at every alignment in a block */
+  void check(std::string const& in_name, std::string const& in_input)
+  {
+    for (size_t shift = 0; shift < 64; ++shift)
+    {
+      // the scanned block starts mid-buffer so the input is misaligned by shift
+      std::string block(shift, 'x');
+      block += in_input;
+      const char* data = block.data() + shift;
+      size_t size = in_input.size();
+
+      line_scanner::lines_t scalar, sse2, avx2;
+      line_scanner::scan_scalar(data, size, scalar);
+      line_scanner::scan_sse2(data, size, sse2);
+      line_scanner::scan_avx2(data, size, avx2);
+
+      if (!same(scalar, sse2) || !same(scalar, avx2))
+      {
+        std::cerr
+          << "mismatch in " << in_name << " at alignment " << shift << ": "
+          << scalar.size() << " scalar, " << sse2.size() << " SSE2, "
+          << avx2.size() << " AVX2 lines\n";
+        ++failures;
+        return;
+      }
+    }
+  }
+
+  /* lines whose fields, quotes and comments fall on either side of the chunk
+   * boundaries */
+  void check_boundaries()
+  {
+    const char* lines[] = {
+      "LABEL\tLDA\tBUFFER,X\n",
+      "  +JSUB   RDREC . read a record\n",
+      "MSG BYTE C'HELLO WORLD' ; comment\n",
+      "  LDA =C'A.B;C'\n",
+      "BAD BYTE C'UNTERMINATED . STILL QUOTED\n",
+      ". comment only\n",
+      "\t \t\n",
+      "NOEOL RSUB"
+    };
+
+    for (const char* line : lines)
+      for (size_t pad = 0; pad < 130; ++pad)
+      {
+        std::string input(pad, ' ');
+        input += line;
+        input += input;
+        check("boundary line '" + std::string(line) + "' padded by " + std::to_string(pad), input);
+      }
+  }
+
+  /* buffers made mostly of the characters the scanners treat specially */
+  void check_random()
+  {
+    const char alphabet[] = "AB1 \t\n.;'=,#@+";
+    std::mt19937 rng(0x5ca9);
+    std::uniform_int_distribution<size_t> length(0, 300);
+    std::uniform_int_distribution<size_t> pick(0, sizeof(alphabet) - 2);
+
+    for (int i = 0; i < 2000; ++i)
+    {
+      std::string input(length(rng), ' ');
+      for (char& c : input)
+        c = alphabet[pick(rng)];
+
+      check("random buffer #" + std::to_string(i), input);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::ifstream in(argv[i], std::ios::binary);
+    if (!in.is_open())
+    {
+      std::cerr << "can not open fixture: " << argv[i] << "\n";
+      return 1;
+    }
+
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    check(argv[i], contents.str());
+  }
+
+  check_boundaries();
+  check_random();
+
+  std::cout
+    << "compared the scalar, SSE2 and AVX2 scanners"
+    << (line_scanner::has_avx2() ? "" : " (AVX2 not supported, fell back to SSE2)")
+    << ": " << failures << " mismatches\n";
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,88 @@
+# measures how the peak resident set of the assembler grows with the input
+#
+# the same program is assembled at two sizes, read from a file or streamed
+# from the standard input, and the growth of the peak resident set reported by
+# 'hasm -s' is divided by the number of entries added. Instructions refer to
+# their source text instead of copying it, which keeps the growth below the
+# bound; copying the labels, mnemonics and operands of every entry exceeds it.
+#
+# streamed input is read into a recycled buffer and only the entries are
+# copied out of it, so in the stdin_comments case the long comment that
+# follows every entry must not add to the growth either
+
+SET(max_bytes_per_entry 288)
+
+# a control section holds 8 * 2^13 entries, which stays within the 20-bit
+# address space
+SET(entries
+"        LDA     #3
+        STA     BUFFER,X
+        +JSUB   FIRST
+        +COMP   =C'EOF'    . compared against a literal
+        BYTE    C'HELLO WORLD'
+        WORD    5
+        ADDR    A,X
+        +LDT    BUFFER
+")
+IF(CASE STREQUAL "stdin_comments")
+  STRING(REPEAT "-" 500 rule)
+  STRING(REGEX REPLACE "\n" "\n. ${rule}\n" entries "${entries}")
+ENDIF()
+FOREACH(i RANGE 12)
+  SET(entries "${entries}${entries}")
+ENDFOREACH()
+
+FOREACH(nr_sections 2 8)
+  SET(asm "${WORK_DIR}/${CASE}_${nr_sections}.asm")
+  FILE(WRITE ${asm} "")
+  FOREACH(i RANGE 1 ${nr_sections})
+    IF(i EQUAL 1)
+      SET(directive START)
+    ELSE()
+      SET(directive CSECT)
+    ENDIF()
+
+    FILE(APPEND ${asm} "SECT${i}   ${directive}   0\nFIRST   RSUB\nBUFFER  RESB    16\n")
+    FILE(APPEND ${asm} "${entries}")
+    FILE(APPEND ${asm} "        LTORG\n")
+  ENDFOREACH()
+  FILE(APPEND ${asm} "        END\n")
+
+  # the listing is long, the statistics are found at its end
+  SET(obj "${WORK_DIR}/${CASE}.obj")
+  SET(log "${WORK_DIR}/${CASE}_${nr_sections}.log")
+  FILE(REMOVE ${obj})
+  IF(CASE MATCHES "^stdin")
+    EXECUTE_PROCESS(
+      COMMAND ${HASM} -s -o ${obj} -
+      INPUT_FILE ${asm}
+      OUTPUT_FILE ${log})
+  ELSE()
+    EXECUTE_PROCESS(
+      COMMAND ${HASM} -s -o ${obj} ${asm}
+      OUTPUT_FILE ${log})
+  ENDIF()
+
+  IF(NOT EXISTS ${obj})
+    MESSAGE(FATAL_ERROR "the program failed to assemble, see ${log}")
+  ENDIF()
+
+  FILE(SIZE ${log} log_size)
+  MATH(EXPR stats_offset "${log_size} - 4096")
+  FILE(READ ${log} stats OFFSET ${stats_offset})
+
+  STRING(REGEX MATCH "Entries: ([0-9]+)" unused "${stats}")
+  SET(entries_${nr_sections} ${CMAKE_MATCH_1})
+  STRING(REGEX MATCH "Peak resident set size: ([0-9]+) KB" unused "${stats}")
+  SET(peak_${nr_sections} ${CMAKE_MATCH_1})
+ENDFOREACH()
+
+MATH(EXPR added_entries "${entries_8} - ${entries_2}")
+MATH(EXPR bytes_per_entry "(${peak_8} - ${peak_2}) * 1024 / ${added_entries}")
+MESSAGE(STATUS "peak resident set: ${peak_2} KB for ${entries_2} entries, "
+               "${peak_8} KB for ${entries_8}; ${bytes_per_entry} bytes per entry")
+
+IF(bytes_per_entry GREATER max_bytes_per_entry)
+  MESSAGE(FATAL_ERROR "the peak resident set grows by ${bytes_per_entry} bytes per entry, "
+                      "past the bound of ${max_bytes_per_entry}")
+ENDIF()
@@ -0,0 +1,39 @@
+# runs the assembler on the program the including script wrote to ${asm}
+#
+# the object program must match ${expected_obj} if that is set, otherwise the
+# output must report ${expected_error} and no object program may be written;
+# if ${expected_nr_errors} is set, exactly that many errors must be reported
+
+FILE(REMOVE ${obj})
+EXECUTE_PROCESS(
+  COMMAND ${HASM} -o ${obj} ${asm}
+  OUTPUT_VARIABLE output
+  ERROR_VARIABLE output)
+
+IF(DEFINED expected_obj)
+  IF(NOT EXISTS ${obj})
+    MESSAGE(FATAL_ERROR "no object program was written:\n${output}")
+  ENDIF()
+
+  FILE(READ ${obj} actual_obj)
+  IF(NOT actual_obj STREQUAL expected_obj)
+    MESSAGE(FATAL_ERROR "unexpected object program:\n${actual_obj}\nexpected:\n${expected_obj}")
+  ENDIF()
+ELSE()
+  STRING(FIND "${output}" "${expected_error}" at)
+  IF(at EQUAL -1)
+    MESSAGE(FATAL_ERROR "expected the error '${expected_error}', got:\n${output}")
+  ENDIF()
+
+  IF(EXISTS ${obj})
+    MESSAGE(FATAL_ERROR "an object program was written for a program that failed to assemble")
+  ENDIF()
+
+  IF(DEFINED expected_nr_errors)
+    STRING(REGEX MATCHALL "\\+- ERROR" errors "${output}")
+    LIST(LENGTH errors nr_errors)
+    IF(NOT nr_errors EQUAL expected_nr_errors)
+      MESSAGE(FATAL_ERROR "expected ${expected_nr_errors} errors, got ${nr_errors}:\n${output}")
+    ENDIF()
+  ENDIF()
+ENDIF()